@@ -0,0 +1,122 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+#include <JsonDefs.h>
+#include <JsonSchema.h>
+#include <JsonErrors.h>
+
+#include <Test.h>
+
+#include "CodeGenerator.h"
+
+using namespace TestsCommon;
+
+namespace {
+
+// Cases which are absent in JSON-Schema-Test-Suite but check that generated code doesn't rely on
+// zero-terminated strings: names and strings contain zero symbols.
+Tests GetLengthTests() {
+	std::string const pattern_schema = R"({"pattern": "^a$"})";
+	std::string const properties_schema =
+		R"({"properties": {"a\u0000b": {"type": "integer"}}, "dependencies": {"a\u0000b": "c"}})";
+	std::string const pattern_properties_schema =
+		R"({"patternProperties": {"^a$": {"type": "integer"}}})";
+	return {
+		Test("length/pattern matches whole string", pattern_schema, R"("a")", true),
+		Test("length/pattern sees symbols after zero", pattern_schema, R"("a\u0000b")", false),
+		Test("length/property with zero is checked", properties_schema,
+		     R"({"a\u0000b": "x", "c": 1})", false),
+		Test("length/property prefix is not property", properties_schema, R"({"a": "x"})", true),
+		Test("length/dependency with zero is checked", properties_schema,
+		     R"({"a\u0000b": 1})", false),
+		Test("length/dependency prefix is not dependency", properties_schema, R"({"a": 1})", true),
+		Test("length/pattern property sees symbols after zero", pattern_properties_schema,
+		     R"({"a\u0000b": "x"})", true),
+		Test("length/pattern property matches", pattern_properties_schema, R"({"a": "x"})", false)
+	};
+}
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Generates header with validation function for every schema of JSON-Schema-Test-Suite and table
+// of test cases with expected results, so generated code is compiled and checked by codegen_tests.
+int main(int argc, char *argv[]) {
+	if (argc != 2) {
+		std::cerr << "Usage: codegen_suite OUTPUT" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	Tests tests = Test::GetTests();
+	Tests const length_tests = GetLengthTests();
+	tests.insert(tests.end(), length_tests.begin(), length_tests.end());
+
+	std::ostringstream code;
+	code << "// Generated by codegen_suite. Do not edit.\n\n#pragma once\n\n";
+	std::map<std::string, size_t> schema_indexes;
+	std::ostringstream cases;
+	for (auto const &test : tests) {
+		std::string const schema = test.GetSchema();
+		auto it = schema_indexes.find(schema);
+		if (it == schema_indexes.end()) {
+			try {
+				// Generator gets only schemas accepted by JsonSchema, as in jsvor_codegen.
+				jsvor::JsonSchema checked(schema);
+				jsvor::JsonDocument document;
+				document.Parse(schema.c_str());
+				size_t const index = schema_indexes.size();
+				CodeGenerator(document).Generate("Suite::Schema" + std::to_string(index),
+				                                 test.GetName(), code);
+				it = schema_indexes.insert({schema, index}).first;
+			}
+			catch (std::exception const &ex) {
+				std::cerr << "Could not generate code for " << test.GetName() << ": "
+				          << ex.what() << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+
+		std::string const data = test.GetInspectedData();
+		cases << "\t{" << ToLiteral(test.GetName().c_str(), test.GetName().size()) << ", "
+		      << "Schema" << it->second << "::Validate, "
+		      << ToLiteral(data.c_str(), data.size()) << ", "
+		      << (test.GetExpectResult() ? "true" : "false") << "},\n";
+	}
+
+	code << "\nnamespace Suite {\n\n"
+	     << "struct Case {\n"
+	     << "\tchar const *name;\n"
+	     << "\tbool (*validate)(rapidjson::Value const &json);\n"
+	     << "\tchar const *data;\n"
+	     << "\tbool expect_result;\n"
+	     << "};\n\n"
+	     << "Case const kCases[] = {\n" << cases.str() << "};\n\n"
+	     << "} // namespace Suite\n";
+
+	std::ofstream output(argv[1]);
+	if (!output.is_open()) {
+		std::cerr << "Cannot open file " << argv[1] << std::endl;
+		return EXIT_FAILURE;
+	}
+	output << code.str();
+	return output ? EXIT_SUCCESS : EXIT_FAILURE;
+}
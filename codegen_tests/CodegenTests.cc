@@ -0,0 +1,28 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <rapidjson/document.h>
+
+#include "GeneratedSuite.h"
+
+TEST(CodegenTests, SuiteTests) {
+	for (auto const &test_case : Suite::kCases) {
+		rapidjson::Document document;
+		document.Parse(test_case.data);
+		ASSERT_FALSE(document.HasParseError()) << test_case.name;
+		EXPECT_EQ(test_case.expect_result, test_case.validate(document)) << test_case.name;
+	}
+}
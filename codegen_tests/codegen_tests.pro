@@ -0,0 +1,39 @@
+# Copyright 2016 lyobzik
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+include(../common.pri)
+
+TEMPLATE = app
+CONFIG += link_prl
+
+QT -= core gui
+
+INCLUDEPATH += ../thirdparty/rapidjson/include/ \
+               $${OUT_PWD} \
+
+
+LIBS += -lre2 -lgtest -lgtest_main -lpthread
+
+# Suite is generated from JSON-Schema-Test-Suite, which is read relative to source directory.
+generated_suite.target = GeneratedSuite.h
+generated_suite.commands = cd $${PWD} && $${OUT_PWD}/$${DESTDIR}/codegen_suite \
+                           $${OUT_PWD}/GeneratedSuite.h
+generated_suite.depends = $${DESTDIR}/codegen_suite
+QMAKE_EXTRA_TARGETS += generated_suite
+
+SOURCES = CodegenTests.cc \
+
+
+PRE_TARGETDEPS += GeneratedSuite.h
+
+QMAKE_POST_LINK += $${DESTDIR}/$${TARGET}
@@ -15,7 +15,9 @@
 #pragma once
 
 #include <list>
+#include <memory>
 #include <string>
+#include <vector>
 #include <exception>
 
 #include "../include/JsonDefs.h"
@@ -224,32 +226,135 @@ enum class SchemaErrors {
 
 	IncorrectMember,
 	IncorrectDependencies,
+	IncorrectRef,
+
+	IncorrectBinarySchema,
+	CantMapBinarySchema,
 
 	Unknown
 }; // enum class SchemaErrors
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // Provides result of document validation with full description of error causes.
+enum class DocumentErrors {
+	None,
+
+	EnumValue,
+	MinimalLength,
+	MaximalLength,
+	Pattern,
+	MinimumValue,
+	MaximumValue,
+	DivisibleValue,
+
+	AdditionalProperty,
+	DependenciesRestrictions,
+	RequiredProperty,
+
+	MinimalItemsCount,
+	MaximalItemsCount,
+	UniqueItems,
+	AdditionalItems,
+
+	DisallowType,
+	NeitherType,
+	Type
+}; // enum class DocumentErrors
+
+// Node of compiled schema program, which raises errors on validation.
+class ErrorSource {
+public:
+	virtual ~ErrorSource() {}
+
+	// Create error raised by this node, name is a property related to error.
+	virtual DocumentErrorPtr CreateError(DocumentErrors error, char const *name) const = 0;
+}; // class ErrorSource
+
+// Error collected in mode of collecting of all errors (see ValidationResult::SetMaxErrors).
+// Instance is validated value, it is nullptr if document was parsed by validator (e.g. document
+// given as string), because such document is destroyed after validation. Name is a property
+// related to error (e.g. additional property), path is JSON Pointer to instance.
+struct ValidationError {
+	DocumentErrors error;
+	ErrorSource const *type;
+	JsonValue const *instance;
+	char const *name;
+	std::string path;
+}; // struct ValidationError
+
+// Result of validation keeps only code of error, node of compiled schema which raised it
+// and path to invalid element, DocumentError and its description are created on request. So the
+// schema must be alive while description of error is requested, schemas referenced by '$ref'
+// which raised errors are kept by result.
 class ValidationResult {
 public:
 	ValidationResult();
 
-	template<typename DocumentErrorType, typename... Args>
-	void SetError(Args&&... args) {
-		error_.reset(new DocumentErrorType(std::forward<Args>(args)...));
-	}
+	// Validation of document object model stops on first error by default. Result with greater
+	// limit collects errors of other values (e.g. of other members or elements) until 'count'
+	// errors are collected. Every value is still validated at most once, so the document is
+	// traversed at most once, as on validation of valid document.
+	void SetMaxErrors(size_t count);
+	size_t GetMaxErrors() const;
+
+	// Name is a property related to error (e.g. additional or required property). Description
+	// and path are kept only for the first error.
+	void AddError(DocumentErrors error, ErrorSource const *type, JsonValue const *instance,
+	              char const *name = nullptr);
+	DocumentErrors GetError() const;
+	// Errors collected if limit of errors is greater than 1.
+	std::vector<ValidationError> const &GetErrors() const;
+	// Remove errors before validation of other document, limit of errors is kept.
+	void Clear();
+	// Add errors of result of validation of other values (e.g. of elements validated by other
+	// thread) as if they were raised after errors of this result.
+	void Append(ValidationResult const &result);
 
 	std::string ErrorDescription() const;
-	void AddPath(std::string const &path);
+	DocumentErrorPtr CreateError() const;
+
+	// Path is added from invalid element to root of document.
+	void AddPath(char const *member);
+	void AddPath(JsonSizeType index);
+	// Add path to collected errors starting from 'first_error'.
+	void AddErrorsPath(char const *member, size_t first_error);
+	void AddErrorsPath(JsonSizeType index, size_t first_error);
+	// Copy names of members, so the result doesn't refer to validated document.
+	void DetachNames();
+	// Forget instances of collected errors, when validated document is destroyed.
+	void DetachInstances();
+	// Keep schema which raised errors, if it is kept by validated schema only during validation
+	// (e.g. referenced schema can be replaced in registry after validation).
+	void KeepSchema(JsonSchemaPtr const &schema);
 
 	operator bool() const;
 
 private:
-	DocumentErrorPtr error_;
+	// Part of path is name of member or index of element if name is nullptr.
+	struct PathPart {
+		char const *member;
+		JsonSizeType index;
+	}; // struct PathPart
+
+	void AddPath(PathPart const &part);
+	PathPart &GetPath(size_t index);
+	PathPart const &GetPath(size_t index) const;
+
+	// Paths of usual depth are stored without allocations.
+	static size_t const kInlinePathSize = 8;
+
+	DocumentErrors error_;
+	ErrorSource const *type_;
+	char const *name_;
+	size_t max_errors_;
+	std::vector<ValidationError> errors_;
+	size_t path_size_;
+	PathPart path_[kInlinePathSize];
+	std::vector<PathPart> deep_path_;
+	std::unique_ptr<char[]> names_;
+	std::vector<JsonSchemaPtr> schemas_;
 }; // class ValidationResult
 
-///////////////////////////////////////////////////////////////////////////////////////////////////
-// Base class for all errors.
 class Error : public std::exception {
 }; // class Error : public std::exception
 
@@ -304,7 +409,7 @@ private:
 	IncorrectDocument& operator=(IncorrectDocument const &) = delete;
 
 	ValidationResult result_;
-	mutable std::string error_description_;
+	std::string error_description_;
 }; // class IncorrectDocument : public Error
 
 } // namespace JsonSchemaValidator
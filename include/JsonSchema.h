@@ -16,6 +16,11 @@
 
 #include <string>
 #include <memory>
+#include <vector>
+#include <cstdio>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
 
 #include "JsonDefs.h"
 #include "JsonErrors.h"
@@ -24,7 +29,28 @@ namespace JsonSchemaValidator {
 
 class ValidationContext;
 
-// Json-schema for validating json-documents.
+// Options of creation of schema.
+struct JsonSchemaOptions {
+	JsonSchemaOptions()
+		: resolver()
+		, trusted(false)
+		, parallel_items_threshold(0) {
+	}
+
+	JsonResolverPtr resolver;
+	// Trusted schema (e.g. generated by application) is not validated by meta-schema. Other
+	// schemas are validated once per process: content of validated schemas is remembered, so
+	// equal schemas are not validated again.
+	bool trusted;
+	// Elements of arrays (restricted by 'items' or 'additionalItems') having more elements than
+	// threshold are validated in parallel by threads of pool shared by library. Errors are the
+	// same as on sequential validation. Parallel validation is disabled by 0.
+	size_t parallel_items_threshold;
+}; // struct JsonSchemaOptions
+
+// Json-schema for validating json-documents. Schema is not changed after creation, so one schema
+// can be used for validation from several threads simultaneously (used resolver must be
+// thread-safe too).
 class JsonSchema {
 public:
 	explicit JsonSchema(char const *schema, JsonResolverPtr const &resolver = nullptr);
@@ -32,6 +58,10 @@ public:
 	// Object used as argument 'schema' must live longer than created JsonSchema.
 	explicit JsonSchema(JsonValue const &schema, JsonResolverPtr const &resolver = nullptr);
 
+	JsonSchema(char const *schema, JsonSchemaOptions const &options);
+	JsonSchema(std::string const &schema, JsonSchemaOptions const &options);
+	JsonSchema(JsonValue const &schema, JsonSchemaOptions const &options);
+
 	// Validate document and throw exception on validation error.
 	void Validate(char const *document) const;
 	void Validate(std::string const &document) const;
@@ -42,11 +72,74 @@ public:
 	void Validate(std::string const &document, ValidationResult &result) const;
 	void Validate(JsonValue const &document, ValidationResult &result) const;
 
+	// Validate document of given length, document needn't be terminated by zero, so it can be
+	// part of larger buffer.
+	void Validate(char const *document, size_t length) const;
+	void Validate(char const *document, size_t length, ValidationResult &result) const;
+#if __cplusplus >= 201703L
+	void Validate(std::string_view document) const {
+		Validate(document.data(), document.size());
+	}
+	void Validate(std::string_view document, ValidationResult &result) const {
+		Validate(document.data(), document.size(), result);
+	}
+#endif
+
+	// Check whether document is valid. Paths to invalid elements are not tracked and errors are not
+	// described, so it's faster than Validate. Exception 'IncorrectJson' is thrown if document
+	// could not be parsed.
+	bool IsValid(char const *document) const;
+	bool IsValid(std::string const &document) const;
+	bool IsValid(char const *document, size_t length) const;
+	bool IsValid(JsonValue const &document) const;
+
+	// Validate document of given length parsed in-situ: strings are decoded inside of document,
+	// so they are not copied, but the document is changed. Document needn't be terminated by
+	// zero.
+	void ValidateInsitu(char *document, size_t length) const;
+	void ValidateInsitu(char *document, size_t length, ValidationResult &result) const;
+
+	// Validate document during its parsing without building DOM of whole document. Values which
+	// cannot be checked incrementally (e.g. restricted by 'enum', 'uniqueItems', 'disallow' or
+	// schema dependencies) are collected before validation, local references and 'extends' are
+	// checked incrementally. Validation stops on first error, so syntax errors after it
+	// are not reported.
+	void ValidateStream(char const *document) const;
+	void ValidateStream(std::FILE *document) const;
+
+	void ValidateStream(char const *document, ValidationResult &result) const;
+	void ValidateStream(std::FILE *document, ValidationResult &result) const;
+
+	// Validate documents in parallel by threads of pool shared by library, result of validation
+	// of documents[i] is stored in results[i]. If some documents could not be parsed, exception
+	// 'IncorrectJson' about the first of them is thrown after other documents are validated.
+	void ValidateBatch(char const *const *documents, size_t count,
+	                   ValidationResult *results) const;
+	void ValidateBatch(std::vector<std::string> const &documents,
+	                   std::vector<ValidationResult> &results) const;
+
+	// Write binary image of schema document and its compiled program, which is loaded without
+	// parsing, validation by meta-schema and compilation (see Load). Image is written in byte
+	// order of this machine.
+	void Save(std::string &image) const;
+
+	// Create schema from binary image written by Save. Image is mapped from file or refers to
+	// memory of caller, which must live while schema is used. Program is read from image and its
+	// regular expressions are compiled on first use. Exception 'IncorrectSchema' is thrown if
+	// image is corrupted or written by other version of library.
+	static JsonSchema Load(char const *path, JsonResolverPtr const &resolver = nullptr);
+	static JsonSchema Load(char const *image, size_t size,
+	                       JsonResolverPtr const &resolver = nullptr);
+
 private:
-	friend class JsonType;
+	friend class ExternalRef;
+
+	JsonSchema();
 
 	void Validate(JsonValue const &document, ValidationContext &context) const;
-	void Initialize(JsonValue const &schema, JsonResolverPtr const &resolver);
+	void Initialize(JsonValue const &schema, JsonSchemaOptions const &options);
+	// Initialize by binary image of schema.
+	void Initialize(JsonResolverPtr const &resolver);
 
 	struct Impl;
 
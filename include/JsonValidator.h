@@ -0,0 +1,73 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+#include <memory>
+
+#include "JsonDefs.h"
+#include "JsonErrors.h"
+#include "JsonSchema.h"
+
+namespace JsonSchemaValidator {
+
+class ReusableDocument;
+
+// Validator of many json-documents by one schema. Memory used for parsing of documents is kept
+// between calls, so after first documents parsing doesn't allocate memory. Validator is not
+// thread-safe, every thread should use its own validator.
+class JsonValidator {
+public:
+	explicit JsonValidator(JsonSchema const &schema);
+	~JsonValidator();
+
+	JsonValidator(JsonValidator const &) = delete;
+	JsonValidator &operator=(JsonValidator const &) = delete;
+
+	// Validate document and throw exception on validation error.
+	void Validate(char const *document);
+	void Validate(std::string const &document);
+
+	// Validate document and return result in 'result' parameter.
+	void Validate(char const *document, ValidationResult &result);
+	void Validate(std::string const &document, ValidationResult &result);
+
+	// Validate document of given length (see JsonSchema::Validate).
+	void Validate(char const *document, size_t length);
+	void Validate(char const *document, size_t length, ValidationResult &result);
+#if __cplusplus >= 201703L
+	void Validate(std::string_view document) {
+		Validate(document.data(), document.size());
+	}
+	void Validate(std::string_view document, ValidationResult &result) {
+		Validate(document.data(), document.size(), result);
+	}
+#endif
+
+	// Check whether document is valid (see JsonSchema::IsValid).
+	bool IsValid(char const *document);
+	bool IsValid(std::string const &document);
+	bool IsValid(char const *document, size_t length);
+
+	// Validate document parsed in-situ (see JsonSchema::ValidateInsitu).
+	void ValidateInsitu(char *document, size_t length);
+	void ValidateInsitu(char *document, size_t length, ValidationResult &result);
+
+private:
+	JsonSchema schema_;
+	std::unique_ptr<ReusableDocument> document_;
+}; // class JsonValidator
+
+} // namespace JsonSchemaValidator
@@ -0,0 +1,86 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <memory>
+
+#include "JsonDefs.h"
+#include "JsonResolver.h"
+
+namespace JsonSchemaValidator {
+
+// Thread-safe resolver which compiles and owns schemas referred by uri. Lookups don't wait for
+// adding of schemas: registered names are published as immutable snapshot, which is replaced
+// atomically and destroyed after lookups using it are finished. Schemas are compiled once per
+// content, so equal schemas added by different uri share compiled types. Schema is available by
+// its uri and by 'id' of its root, empty fragment ('#') of uri is ignored.
+class SchemaRegistry : public JsonResolver {
+public:
+	class Reader;
+
+	SchemaRegistry();
+	virtual ~SchemaRegistry();
+
+	SchemaRegistry(SchemaRegistry const &) = delete;
+	SchemaRegistry &operator=(SchemaRegistry const &) = delete;
+
+	// Compile schema and register it by uri, previous schema with the same uri is replaced.
+	// Changing of registry waits for readers which could find previous schemas (see Reader), so
+	// std::logic_error is thrown if calling thread has reader of the registry. References of
+	// schema are bound to schemas registered at that moment, so referred schemas should be added
+	// first (other references are resolved during validation). Trusted schema is not validated by
+	// meta-schema.
+	JsonSchemaPtr Add(std::string const &uri, char const *schema, bool trusted = false);
+	JsonSchemaPtr Add(std::string const &uri, std::string const &schema, bool trusted = false);
+
+	// Make schema registered by uri (now or later) available by alias too. As Add, it throws
+	// std::logic_error if calling thread has reader of the registry.
+	void AddAlias(std::string const &alias, std::string const &uri);
+
+	virtual JsonSchemaPtr Resolve(std::string const &ref) const;
+
+private:
+	struct Impl;
+	struct Names;
+	class Resolver;
+
+	std::shared_ptr<Impl> impl_;
+}; // class SchemaRegistry
+
+// Access to schemas of registry without locks and changing of reference counters, so many threads
+// can validate documents by the same schemas. Schemas found by reader are not destroyed while
+// reader exists, even if they are replaced in registry. Reader should live as long as validation
+// of document: changing of registry waits for existing readers. Reader doesn't own registry, so
+// registry must outlive its readers.
+class SchemaRegistry::Reader {
+public:
+	explicit Reader(SchemaRegistry const &registry);
+	~Reader();
+
+	Reader(Reader const &) = delete;
+	Reader &operator=(Reader const &) = delete;
+
+	// Return nullptr if schema isn't registered.
+	JsonSchema const *Find(std::string const &uri) const;
+
+private:
+	Impl const *registry_;
+	std::atomic<size_t> &readers_;
+	Names const *names_;
+}; // class SchemaRegistry::Reader
+
+} // namespace JsonSchemaValidator
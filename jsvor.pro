@@ -20,6 +20,9 @@ SUBDIRS = jsvor \
           tests \
           perftests \
           jsvor_validator \
+          jsvor_codegen \
+          codegen_suite \
+          codegen_tests \
 
 
 jsvor.file = lib/jsvor.pro
@@ -27,8 +30,14 @@ tests_common.file = tests_common/tests_common.pro
 tests.file = tests/tests.pro
 perftests.file = perftests/perftests.pro
 jsvor_validator.file = jsvor_validator/jsvor_validator.pro
+jsvor_codegen.file = jsvor_codegen/jsvor_codegen.pro
+codegen_suite.file = codegen_suite/codegen_suite.pro
+codegen_tests.file = codegen_tests/codegen_tests.pro
 
 tests_common.depends = jsvor
 tests.depends = tests_common jsvor
 perftests.depends = tests_common tests jsvor
 jsvor_validator.depends = jsvor
+jsvor_codegen.depends = jsvor
+codegen_suite.depends = tests_common jsvor
+codegen_tests.depends = codegen_suite
@@ -0,0 +1,673 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CodeGenerator.h"
+
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <iomanip>
+
+#include <rapidjson/pointer.h>
+#include <rapidjson/writer.h>
+#include <rapidjson/stringbuffer.h>
+
+std::string ToLiteral(char const *value, size_t length) {
+	std::ostringstream literal;
+	literal << '"';
+	for (size_t i = 0; i < length; ++i) {
+		unsigned char symbol = static_cast<unsigned char>(value[i]);
+		if (symbol == '"' || symbol == '\\') {
+			literal << '\\' << symbol;
+		}
+		else if (symbol < 0x20 || symbol >= 0x7f) {
+			// Octal escapes have fixed length, so they can't swallow next symbols.
+			literal << '\\' << std::oct << std::setw(3) << std::setfill('0')
+			        << static_cast<unsigned>(symbol) << std::dec;
+		}
+		else {
+			literal << symbol;
+		}
+	}
+	literal << '"';
+	return literal.str();
+}
+
+std::string ToLiteral(jsvor::JsonValue const &value) {
+	return ToLiteral(value.GetString(), value.GetStringLength());
+}
+
+namespace {
+
+std::string ToJsonLiteral(jsvor::JsonValue const &value) {
+	rapidjson::StringBuffer buffer;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+	value.Accept(writer);
+	return ToLiteral(buffer.GetString(), buffer.GetSize());
+}
+
+std::string ToNumberLiteral(jsvor::JsonValue const &value) {
+	std::ostringstream literal;
+	if (value.IsInt64()) {
+		int64_t number = value.GetInt64();
+		if (number == std::numeric_limits<int64_t>::min()) {
+			literal << "(" << (number + 1) << "LL - 1)";
+		}
+		else {
+			literal << number << "LL";
+		}
+		return literal.str();
+	}
+
+	literal << std::setprecision(std::numeric_limits<double>::max_digits10) << value.GetDouble();
+	std::string result = literal.str();
+	if (result.find_first_of(".e") == std::string::npos) {
+		result += ".0";
+	}
+	return result;
+}
+
+// Names can contain zero symbols, so generated lookup gets explicit length.
+std::string ToHasMember(jsvor::JsonValue const &name) {
+	return "HasMember(json, " + ToLiteral(name) + ", " +
+		std::to_string(name.GetStringLength()) + "u)";
+}
+
+std::string ToSizeLiteral(jsvor::JsonValue const &value) {
+	if (value.IsUint64()) {
+		return std::to_string(value.GetUint64()) + "ull";
+	}
+	return value.IsNumber() && value.GetDouble() > 0.0 ? ToNumberLiteral(value) : "0ull";
+}
+
+} // namespace
+
+CodeGenerator::CodeGenerator(jsvor::JsonValue const &root)
+	: root_(root)
+	, functions_()
+	, function_indexes_()
+	, patterns_()
+	, enums_() {
+}
+
+void CodeGenerator::Generate(std::string const &name_space, std::string const &source,
+                             std::ostream &os) {
+	// Functions are generated first, because they collect patterns and enums.
+	AddFunction(root_);
+	std::ostringstream functions;
+	for (size_t index = 0; index < functions_.size(); ++index) {
+		GenerateFunction(index, functions);
+	}
+
+	std::vector<std::string> namespaces;
+	for (size_t begin = 0; begin <= name_space.size();) {
+		size_t end = std::min(name_space.find("::", begin), name_space.size());
+		namespaces.push_back(name_space.substr(begin, end - begin));
+		begin = end + 2;
+	}
+
+	os << "// Generated by jsvor_codegen from " << source << ". Do not edit.\n"
+	   << "\n#pragma once\n"
+	   << "\n#include <cmath>\n#include <cstring>\n#include <limits>\n#include <string>\n"
+	   << "\n#include <rapidjson/document.h>\n";
+	if (!patterns_.empty()) {
+		os << "\n#if defined(USE_STD_REGEX)\n#include <regex>\n#else // defined(USE_STD_REGEX)\n"
+		   << "#include <re2/re2.h>\n#endif // defined(USE_STD_REGEX)\n";
+	}
+	os << "\n";
+	for (auto const &name : namespaces) {
+		os << "namespace " << name << " {\n";
+	}
+	os << "\ntypedef rapidjson::Value JsonValue;\n\nnamespace detail {\n\n";
+	GenerateHelpers(os);
+
+	for (size_t index = 0; index < patterns_.size(); ++index) {
+		os << "inline Regex const &Pattern" << index << "() {\n"
+		   << "\tstatic Regex const regex(" << patterns_[index] << ");\n"
+		   << "\treturn regex;\n}\n\n";
+	}
+	for (size_t index = 0; index < enums_.size(); ++index) {
+		os << "inline JsonValue const &Enum" << index << "() {\n"
+		   << "\tstatic Literal const values(" << enums_[index] << ");\n"
+		   << "\treturn values.document;\n}\n\n";
+	}
+	for (size_t index = 0; index < functions_.size(); ++index) {
+		os << "inline bool Validate" << index << "(JsonValue const &json);\n";
+	}
+	os << "\n" << functions.str() << "} // namespace detail\n\n"
+	   << "// Returns true if json satisfies to schema " << source << ".\n"
+	   << "inline bool Validate(JsonValue const &json) {\n"
+	   << "\treturn detail::Validate0(json);\n}\n\n";
+	for (auto name = namespaces.rbegin(); name != namespaces.rend(); ++name) {
+		os << "} // namespace " << *name << "\n";
+	}
+}
+
+unsigned CodeGenerator::GetKinds(jsvor::JsonValue const &type) {
+	static std::map<std::string, unsigned> const kinds = {
+		{"null", kNull}, {"boolean", kBoolean}, {"object", kObject}, {"array", kArray},
+		{"string", kString}, {"integer", kInteger}, {"number", kNumber}, {"any", kAny}
+	};
+	// As in JsonType::Create unknown types are handled as 'any'.
+	auto it = kinds.find(std::string(type.GetString(), type.GetStringLength()));
+	return it != kinds.end() ? it->second : static_cast<unsigned>(kAny);
+}
+
+jsvor::JsonValue const *CodeGenerator::GetChild(jsvor::JsonValue const &schema,
+                                                char const *name) {
+	auto it = schema.FindMember(name);
+	return it != schema.MemberEnd() ? &it->value : nullptr;
+}
+
+size_t CodeGenerator::AddFunction(jsvor::JsonValue const &schema) {
+	auto it = function_indexes_.find(&schema);
+	if (it != function_indexes_.end()) {
+		return it->second;
+	}
+	function_indexes_.insert({&schema, functions_.size()});
+	functions_.push_back(&schema);
+	return functions_.size() - 1;
+}
+
+size_t CodeGenerator::AddPattern(jsvor::JsonValue const &pattern) {
+	patterns_.push_back("std::string(" + ToLiteral(pattern) + ", " +
+	                    std::to_string(pattern.GetStringLength()) + "u)");
+	return patterns_.size() - 1;
+}
+
+size_t CodeGenerator::AddEnum(jsvor::JsonValue const &values) {
+	enums_.push_back(ToJsonLiteral(values));
+	return enums_.size() - 1;
+}
+
+jsvor::JsonValue const &CodeGenerator::Resolve(jsvor::JsonValue const &ref) const {
+	// Only references inside of the schema can be compiled ahead-of-time.
+	std::string uri(ref.GetString(), ref.GetStringLength());
+	if (uri.empty() || uri[0] != '#') {
+		throw CodegenError("Could not generate code for external reference " + uri);
+	}
+	jsvor::JsonValue const *target = rapidjson::Pointer(uri.c_str()).Get(root_);
+	if (!target || !target->IsObject()) {
+		throw CodegenError("Could not resolve reference " + uri);
+	}
+	return *target;
+}
+
+void CodeGenerator::GenerateFunction(size_t index, std::ostream &os) {
+	jsvor::JsonValue const &schema = *functions_[index];
+	std::ostringstream body;
+	if (schema.IsObject()) {
+		jsvor::JsonValue const *ref = GetChild(schema, "$ref");
+		if (ref && ref->IsString()) {
+			body << "\tif (!Validate" << AddFunction(Resolve(*ref)) << "(json)) return false;\n";
+		}
+
+		jsvor::JsonValue const *extends = GetChild(schema, "extends");
+		if (extends && extends->IsObject()) {
+			body << "\tif (!Validate" << AddFunction(*extends) << "(json)) return false;\n";
+		}
+		else if (extends && extends->IsArray()) {
+			for (auto base = extends->Begin(); base != extends->End(); ++base) {
+				body << "\tif (!Validate" << AddFunction(*base) << "(json)) return false;\n";
+			}
+		}
+
+		GenerateTypes(schema, body);
+
+		jsvor::JsonValue const *values = GetChild(schema, "enum");
+		if (values && values->IsArray()) {
+			body << "\tif (!Contains(Enum" << AddEnum(*values) << "(), json)) return false;\n";
+		}
+
+		GenerateString(schema, body);
+		GenerateNumber(schema, body);
+		GenerateObject(schema, body);
+		GenerateArray(schema, body);
+	}
+
+	std::string const checks = body.str();
+	os << "inline bool Validate" << index << "(JsonValue const &"
+	   << (checks.empty() ? "/*json*/" : "json") << ") {\n" << checks << "\treturn true;\n}\n\n";
+}
+
+void CodeGenerator::GenerateTypes(jsvor::JsonValue const &schema, std::ostream &os) {
+	for (auto const &keyword : {"type", "disallow"}) {
+		jsvor::JsonValue const *type = GetChild(schema, keyword);
+		if (!type) {
+			continue;
+		}
+
+		unsigned kinds = 0;
+		std::vector<size_t> functions;
+		if (type->IsString()) {
+			kinds = GetKinds(*type);
+		}
+		else if (type->IsObject()) {
+			functions.push_back(AddFunction(*type));
+		}
+		else if (type->IsArray()) {
+			for (auto element = type->Begin(); element != type->End(); ++element) {
+				if (element->IsString()) {
+					kinds |= GetKinds(*element);
+				}
+				else if (element->IsObject()) {
+					functions.push_back(AddFunction(*element));
+				}
+			}
+		}
+
+		bool is_type = (keyword == std::string("type"));
+		if (is_type && kinds == kAny) {
+			continue;
+		}
+		if (is_type) {
+			os << "\tif (!(GetKind(json) & 0x" << std::hex << kinds << std::dec << ")";
+			for (auto const &function : functions) {
+				os << " && !Validate" << function << "(json)";
+			}
+		}
+		else {
+			os << "\tif ((GetKind(json) & 0x" << std::hex << kinds << std::dec << ")";
+			for (auto const &function : functions) {
+				os << " || Validate" << function << "(json)";
+			}
+		}
+		os << ") return false;\n";
+	}
+}
+
+void CodeGenerator::GenerateString(jsvor::JsonValue const &schema, std::ostream &os) {
+	jsvor::JsonValue const *min_length = GetChild(schema, "minLength");
+	jsvor::JsonValue const *max_length = GetChild(schema, "maxLength");
+	jsvor::JsonValue const *pattern = GetChild(schema, "pattern");
+	if (!min_length && !max_length && !pattern) {
+		return;
+	}
+
+	os << "\tif (json.IsString()) {\n";
+	if (min_length) {
+		os << "\t\tif (json.GetStringLength() < " << ToSizeLiteral(*min_length)
+		   << ") return false;\n";
+	}
+	if (max_length) {
+		os << "\t\tif (json.GetStringLength() > " << ToSizeLiteral(*max_length)
+		   << ") return false;\n";
+	}
+	if (pattern && pattern->IsString()) {
+		os << "\t\tif (!Match(Pattern" << AddPattern(*pattern)
+		   << "(), json.GetString(), json.GetStringLength())) return false;\n";
+	}
+	os << "\t}\n";
+}
+
+void CodeGenerator::GenerateNumber(jsvor::JsonValue const &schema, std::ostream &os) {
+	jsvor::JsonValue const *minimum = GetChild(schema, "minimum");
+	jsvor::JsonValue const *maximum = GetChild(schema, "maximum");
+	jsvor::JsonValue const *divisible_by = GetChild(schema, "divisibleBy");
+	if (!minimum && !maximum && !divisible_by) {
+		return;
+	}
+
+	auto is_exclusive = [&schema](char const *name) {
+		jsvor::JsonValue const *exclusive = GetChild(schema, name);
+		return exclusive && exclusive->IsTrue() ? "true" : "false";
+	};
+
+	os << "\tif (json.IsNumber()) {\n";
+	if (minimum) {
+		os << "\t\tif (!NotLess(json, " << ToNumberLiteral(*minimum) << ", "
+		   << is_exclusive("exclusiveMinimum") << ")) return false;\n";
+	}
+	if (maximum) {
+		os << "\t\tif (!NotGreater(json, " << ToNumberLiteral(*maximum) << ", "
+		   << is_exclusive("exclusiveMaximum") << ")) return false;\n";
+	}
+	if (divisible_by) {
+		os << "\t\tif (!IsDivisible(json, " << ToNumberLiteral(*divisible_by)
+		   << ")) return false;\n";
+	}
+	os << "\t}\n";
+}
+
+void CodeGenerator::GenerateObject(jsvor::JsonValue const &schema, std::ostream &os) {
+	jsvor::JsonValue const *properties = GetChild(schema, "properties");
+	jsvor::JsonValue const *pattern_properties = GetChild(schema, "patternProperties");
+	jsvor::JsonValue const *additional = GetChild(schema, "additionalProperties");
+	jsvor::JsonValue const *dependencies = GetChild(schema, "dependencies");
+	if (additional && additional->IsTrue()) {
+		additional = nullptr;
+	}
+	if (!properties && !pattern_properties && !additional && !dependencies) {
+		return;
+	}
+
+	// Properties are grouped by length of name for switch in generated code.
+	struct Property {
+		jsvor::JsonValue const *name;
+		size_t function;
+		size_t required;
+	};
+	std::map<size_t, std::vector<Property>> properties_by_length;
+	size_t required_count = 0;
+	if (properties && properties->IsObject()) {
+		for (auto property = properties->MemberBegin(); property != properties->MemberEnd();
+		     ++property) {
+			auto &same_length = properties_by_length[property->name.GetStringLength()];
+			bool is_duplicate = false;
+			for (auto const &other : same_length) {
+				is_duplicate = is_duplicate || (*other.name == property->name);
+			}
+			if (is_duplicate) {
+				continue;
+			}
+
+			jsvor::JsonValue const *required = property->value.IsObject() ?
+				GetChild(property->value, "required") : nullptr;
+			bool is_required = required && required->IsTrue();
+			same_length.push_back({&property->name, AddFunction(property->value),
+			                       is_required ? required_count++ : SIZE_MAX});
+		}
+	}
+	std::vector<std::pair<size_t, size_t>> patterns;
+	if (pattern_properties && pattern_properties->IsObject()) {
+		for (auto property = pattern_properties->MemberBegin();
+		     property != pattern_properties->MemberEnd(); ++property) {
+			patterns.push_back({AddPattern(property->name), AddFunction(property->value)});
+		}
+	}
+
+	os << "\tif (json.IsObject()) {\n";
+	if (required_count > 0) {
+		os << "\t\tbool found[" << required_count << "] = {};\n";
+	}
+	if (!properties_by_length.empty() || !patterns.empty() || additional) {
+		os << "\t\tfor (auto member = json.MemberBegin(); member != json.MemberEnd(); ++member) {\n";
+		if (!properties_by_length.empty() || !patterns.empty()) {
+			os << "\t\t\tchar const *name = member->name.GetString();\n";
+		}
+		if (additional) {
+			os << "\t\t\tbool described = false;\n";
+		}
+		if (!properties_by_length.empty()) {
+			os << "\t\t\tswitch (member->name.GetStringLength()) {\n";
+			for (auto const &same_length : properties_by_length) {
+				os << "\t\t\tcase " << same_length.first << ":\n";
+				char const *condition = "if";
+				for (auto const &property : same_length.second) {
+					os << "\t\t\t\t" << condition << " (std::memcmp(name, "
+					   << ToLiteral(*property.name) << ", " << same_length.first << ") == 0) {\n";
+					if (additional) {
+						os << "\t\t\t\t\tdescribed = true;\n";
+					}
+					if (property.required != SIZE_MAX) {
+						os << "\t\t\t\t\tfound[" << property.required << "] = true;\n";
+					}
+					os << "\t\t\t\t\tif (!Validate" << property.function
+					   << "(member->value)) return false;\n\t\t\t\t}\n";
+					condition = "else if";
+				}
+				os << "\t\t\t\tbreak;\n";
+			}
+			os << "\t\t\t}\n";
+		}
+		for (auto const &pattern : patterns) {
+			os << "\t\t\tif (Match(Pattern" << pattern.first
+			   << "(), name, member->name.GetStringLength())) {\n";
+			if (additional) {
+				os << "\t\t\t\tdescribed = true;\n";
+			}
+			os << "\t\t\t\tif (!Validate" << pattern.second << "(member->value)) return false;\n"
+			   << "\t\t\t}\n";
+		}
+		if (additional && additional->IsObject()) {
+			os << "\t\t\tif (!described && !Validate" << AddFunction(*additional)
+			   << "(member->value)) return false;\n";
+		}
+		else if (additional) {
+			os << "\t\t\tif (!described) return false;\n";
+		}
+		os << "\t\t}\n";
+	}
+	for (size_t index = 0; index < required_count; ++index) {
+		os << "\t\tif (!found[" << index << "]) return false;\n";
+	}
+
+	if (dependencies && dependencies->IsObject()) {
+		for (auto dependency = dependencies->MemberBegin();
+		     dependency != dependencies->MemberEnd(); ++dependency) {
+			std::string const has_member = ToHasMember(dependency->name);
+			jsvor::JsonValue const &value = dependency->value;
+			if (value.IsString()) {
+				os << "\t\tif (" << has_member << " && !" << ToHasMember(value)
+				   << ") return false;\n";
+			}
+			else if (value.IsArray()) {
+				for (auto name = value.Begin(); name != value.End(); ++name) {
+					if (name->IsString()) {
+						os << "\t\tif (" << has_member << " && !" << ToHasMember(*name)
+						   << ") return false;\n";
+					}
+				}
+			}
+			else if (value.IsObject()) {
+				os << "\t\tif (" << has_member << " && !Validate" << AddFunction(value)
+				   << "(json)) return false;\n";
+			}
+		}
+	}
+	os << "\t}\n";
+}
+
+void CodeGenerator::GenerateArray(jsvor::JsonValue const &schema, std::ostream &os) {
+	jsvor::JsonValue const *min_items = GetChild(schema, "minItems");
+	jsvor::JsonValue const *max_items = GetChild(schema, "maxItems");
+	jsvor::JsonValue const *unique_items = GetChild(schema, "uniqueItems");
+	jsvor::JsonValue const *items = GetChild(schema, "items");
+	jsvor::JsonValue const *additional = GetChild(schema, "additionalItems");
+	if (unique_items && !unique_items->IsTrue()) {
+		unique_items = nullptr;
+	}
+	if (!items || !items->IsArray() || (additional && additional->IsTrue())) {
+		additional = nullptr;
+	}
+	if (!min_items && !max_items && !unique_items && !items) {
+		return;
+	}
+
+	os << "\tif (json.IsArray()) {\n";
+	if (min_items) {
+		os << "\t\tif (json.Size() < " << ToSizeLiteral(*min_items) << ") return false;\n";
+	}
+	if (max_items) {
+		os << "\t\tif (json.Size() > " << ToSizeLiteral(*max_items) << ") return false;\n";
+	}
+	if (unique_items) {
+		os << "\t\tif (!IsUnique(json)) return false;\n";
+	}
+	if (items && items->IsObject()) {
+		os << "\t\tfor (auto element = json.Begin(); element != json.End(); ++element) {\n"
+		   << "\t\t\tif (!Validate" << AddFunction(*items) << "(*element)) return false;\n"
+		   << "\t\t}\n";
+	}
+	else if (items && items->IsArray()) {
+		rapidjson::SizeType index = 0;
+		for (auto item = items->Begin(); item != items->End(); ++item) {
+			os << "\t\tif (json.Size() > " << index << "u && !Validate" << AddFunction(*item)
+			   << "(json[" << index << "u])) return false;\n";
+			++index;
+		}
+		if (additional && additional->IsObject()) {
+			os << "\t\tfor (rapidjson::SizeType i = " << index << "u; i < json.Size(); ++i) {\n"
+			   << "\t\t\tif (!Validate" << AddFunction(*additional) << "(json[i])) return false;\n"
+			   << "\t\t}\n";
+		}
+		else if (additional) {
+			os << "\t\tif (json.Size() > " << index << "u) return false;\n";
+		}
+	}
+	os << "\t}\n";
+}
+
+void CodeGenerator::GenerateHelpers(std::ostream &os) const {
+	os << R"(enum Kinds {
+	kNull = 0x01,
+	kBoolean = 0x02,
+	kObject = 0x04,
+	kArray = 0x08,
+	kString = 0x10,
+	kInteger = 0x20,
+	kDouble = 0x40
+};
+
+inline unsigned GetKind(JsonValue const &json) {
+	switch (json.GetType()) {
+	case rapidjson::kNullType: return kNull;
+	case rapidjson::kFalseType: return kBoolean;
+	case rapidjson::kTrueType: return kBoolean;
+	case rapidjson::kObjectType: return kObject;
+	case rapidjson::kArrayType: return kArray;
+	case rapidjson::kStringType: return kString;
+	default: return json.IsDouble() ? kDouble : kInteger;
+	}
+}
+
+inline bool NotLess(JsonValue const &json, double limit, bool exclusive) {
+	double const value = json.GetDouble();
+	return exclusive ? limit < value : limit <= value;
+}
+
+inline bool NotLess(JsonValue const &json, long long limit, bool exclusive) {
+	if (json.IsInt64()) {
+		return exclusive ? limit < json.GetInt64() : limit <= json.GetInt64();
+	}
+	return json.IsUint64() || NotLess(json, static_cast<double>(limit), exclusive);
+}
+
+inline bool NotGreater(JsonValue const &json, double limit, bool exclusive) {
+	double const value = json.GetDouble();
+	return exclusive ? value < limit : value <= limit;
+}
+
+inline bool NotGreater(JsonValue const &json, long long limit, bool exclusive) {
+	if (json.IsInt64()) {
+		return exclusive ? json.GetInt64() < limit : json.GetInt64() <= limit;
+	}
+	return !json.IsUint64() && NotGreater(json, static_cast<double>(limit), exclusive);
+}
+
+inline bool IsDivisible(JsonValue const &json, double divider) {
+	double const division = json.GetDouble() / divider;
+	return std::fabs(division - std::round(division)) <= std::numeric_limits<double>::epsilon();
+}
+
+inline bool IsDivisible(JsonValue const &json, long long divider) {
+	if (json.IsInt64() && divider != -1) {
+		return json.GetInt64() % divider == 0;
+	}
+	return IsDivisible(json, static_cast<double>(divider));
+}
+
+inline bool IsEqual(JsonValue const &left, JsonValue const &right) {
+	if (left.IsNumber() && right.IsNumber()) {
+		if (left.IsInt64() && right.IsInt64()) {
+			return left.GetInt64() == right.GetInt64();
+		}
+		if (left.IsUint64() && right.IsUint64()) {
+			return left.GetUint64() == right.GetUint64();
+		}
+		return left.GetDouble() == right.GetDouble();
+	}
+	if (left.GetType() != right.GetType()) {
+		return false;
+	}
+	switch (left.GetType()) {
+	case rapidjson::kObjectType:
+		if (left.MemberCount() != right.MemberCount()) {
+			return false;
+		}
+		for (auto member = left.MemberBegin(); member != left.MemberEnd(); ++member) {
+			auto other = right.FindMember(member->name);
+			if (other == right.MemberEnd() || !IsEqual(member->value, other->value)) {
+				return false;
+			}
+		}
+		return true;
+	case rapidjson::kArrayType:
+		if (left.Size() != right.Size()) {
+			return false;
+		}
+		for (rapidjson::SizeType i = 0; i < left.Size(); ++i) {
+			if (!IsEqual(left[i], right[i])) {
+				return false;
+			}
+		}
+		return true;
+	case rapidjson::kStringType:
+		return left.GetStringLength() == right.GetStringLength() &&
+			std::memcmp(left.GetString(), right.GetString(), left.GetStringLength()) == 0;
+	default:
+		return true;
+	}
+}
+
+inline bool IsUnique(JsonValue const &json) {
+	for (rapidjson::SizeType i = 1; i < json.Size(); ++i) {
+		for (rapidjson::SizeType j = 0; j < i; ++j) {
+			if (IsEqual(json[i], json[j])) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+inline bool Contains(JsonValue const &values, JsonValue const &json) {
+	for (auto value = values.Begin(); value != values.End(); ++value) {
+		if (IsEqual(*value, json)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+inline bool HasMember(JsonValue const &json, char const *name, rapidjson::SizeType length) {
+	return json.FindMember(JsonValue(rapidjson::StringRef(name, length))) != json.MemberEnd();
+}
+
+struct Literal {
+	explicit Literal(char const *json) : document() { document.Parse(json); }
+	rapidjson::Document document;
+};
+
+)";
+	if (!patterns_.empty()) {
+		os << R"(#if defined(USE_STD_REGEX)
+typedef std::regex Regex;
+
+inline bool Match(Regex const &regex, char const *value, rapidjson::SizeType length) {
+	return std::regex_search(value, value + length, regex);
+}
+#else // defined(USE_STD_REGEX)
+typedef re2::RE2 Regex;
+
+inline bool Match(Regex const &regex, char const *value, rapidjson::SizeType length) {
+	return re2::RE2::PartialMatch(re2::StringPiece(value, length), regex);
+}
+#endif // defined(USE_STD_REGEX)
+
+)";
+	}
+}
+
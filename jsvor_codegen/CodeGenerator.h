@@ -0,0 +1,86 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <stdexcept>
+
+#include <JsonDefs.h>
+
+// Typedef for jsvor.
+namespace jsvor = JsonSchemaValidator;
+
+// Error of generation, e.g. schema contains external reference.
+class CodegenError : public std::runtime_error {
+public:
+	explicit CodegenError(std::string const &error)
+		: std::runtime_error(error) {
+	}
+}; // class CodegenError
+
+// Literal of C++ string with given content, symbols which are not printable are escaped.
+std::string ToLiteral(char const *value, size_t length);
+std::string ToLiteral(jsvor::JsonValue const &value);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Generator of header with validation function specialized for single schema. Every subschema
+// is turned into separate inline function, so generated code contains only checks required by
+// the schema and doesn't look up keywords during validation.
+class CodeGenerator {
+public:
+	explicit CodeGenerator(jsvor::JsonValue const &root);
+
+	void Generate(std::string const &name_space, std::string const &source, std::ostream &os);
+
+private:
+	// Bit mask of value kinds in generated code.
+	enum Kinds {
+		kNull = 0x01,
+		kBoolean = 0x02,
+		kObject = 0x04,
+		kArray = 0x08,
+		kString = 0x10,
+		kInteger = 0x20,
+		kDouble = 0x40,
+		kNumber = kInteger | kDouble,
+		kAny = 0x7f
+	};
+
+	static unsigned GetKinds(jsvor::JsonValue const &type);
+	static jsvor::JsonValue const *GetChild(jsvor::JsonValue const &schema, char const *name);
+
+	size_t AddFunction(jsvor::JsonValue const &schema);
+	size_t AddPattern(jsvor::JsonValue const &pattern);
+	size_t AddEnum(jsvor::JsonValue const &values);
+	jsvor::JsonValue const &Resolve(jsvor::JsonValue const &ref) const;
+
+	void GenerateFunction(size_t index, std::ostream &os);
+	void GenerateTypes(jsvor::JsonValue const &schema, std::ostream &os);
+	void GenerateString(jsvor::JsonValue const &schema, std::ostream &os);
+	void GenerateNumber(jsvor::JsonValue const &schema, std::ostream &os);
+	void GenerateObject(jsvor::JsonValue const &schema, std::ostream &os);
+	void GenerateArray(jsvor::JsonValue const &schema, std::ostream &os);
+
+	void GenerateHelpers(std::ostream &os) const;
+
+	jsvor::JsonValue const &root_;
+	std::vector<jsvor::JsonValue const *> functions_;
+	std::map<jsvor::JsonValue const *, size_t> function_indexes_;
+	std::vector<std::string> patterns_;
+	std::vector<std::string> enums_;
+}; // class CodeGenerator
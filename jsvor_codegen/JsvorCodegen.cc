@@ -0,0 +1,102 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+#include <JsonDefs.h>
+#include <JsonSchema.h>
+#include <JsonErrors.h>
+
+#include "CodeGenerator.h"
+
+// Show error and help.
+template <typename Value>
+void Show(std::ostream &os, const Value& value) {
+	os << value;
+}
+
+template <typename Value, typename... Values>
+void Show(std::ostream &os, const Value &value, const Values&... values) {
+	Show(os, value);
+	Show(os, values...);
+}
+
+void Usage() {
+	Show(std::cout, "Usage: jsvor_codegen SCHEMA NAMESPACE [OUTPUT]");
+	std::cout << std::endl;
+	exit(EXIT_SUCCESS);
+}
+
+template <typename... Args>
+void ShowError(const Args&... args) {
+	Show(std::cerr, args...);
+	std::cerr << std::endl;
+	exit(EXIT_FAILURE);
+}
+
+// Load files.
+std::string LoadFileContent(const std::string &file_path) {
+	std::ifstream file(file_path.c_str());
+	if (not file.is_open()) {
+		ShowError("Cannot open file ", file_path);
+	}
+	return std::string((std::istreambuf_iterator<char>(file)),
+	                   std::istreambuf_iterator<char>());
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[]) {
+	// Parse arguments.
+	if (argc < 3 || argc > 4) {
+		Usage();
+	}
+	std::string schema_path = argv[1];
+	std::string name_space = argv[2];
+
+	// Load and check schema. Construction of JsonSchema parses schema and checks it
+	// both by core schema and by JsonType::Create, so generator gets only correct schemas.
+	const std::string content = LoadFileContent(schema_path);
+	try {
+		jsvor::JsonSchema schema(content);
+	}
+	catch (const jsvor::Error &ex) {
+		ShowError("Could not load schema from ", schema_path, ": ", ex.what());
+	}
+	jsvor::JsonDocument document;
+	document.Parse(content.c_str());
+
+	// Generate code.
+	std::ostringstream code;
+	try {
+		CodeGenerator(document).Generate(name_space, schema_path, code);
+	}
+	catch (const CodegenError &ex) {
+		ShowError(ex.what());
+	}
+	if (argc == 4) {
+		std::ofstream output(argv[3]);
+		if (not output.is_open()) {
+			ShowError("Cannot open file ", argv[3]);
+		}
+		output << code.str();
+	}
+	else {
+		std::cout << code.str();
+	}
+	exit(EXIT_SUCCESS);
+}
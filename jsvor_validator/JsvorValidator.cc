@@ -22,32 +22,13 @@
 #include <JsonDefs.h>
 #include <JsonSchema.h>
 #include <JsonErrors.h>
-#include <JsonResolver.h>
+#include <SchemaRegistry.h>
 
-// Resolver and typedef for jsvor.
+// Typedefs for jsvor.
 namespace jsvor = JsonSchemaValidator;
 
-class SimpleResolver : public jsvor::JsonResolver {
-public:
-	explicit SimpleResolver()
-	: schemas_() {
-	}
-
-	virtual jsvor::JsonSchemaPtr Resolve(const std::string &ref) const {
-		auto it = schemas_.find(ref);
-		return it != schemas_.end() ? it->second : jsvor::JsonSchemaPtr();
-	}
-
-	void AddSchema(const std::string &schema_path, const jsvor::JsonSchemaPtr &schema) {
-		schemas_.insert({schema_path, schema});
-	}
-
-private:
-	std::map<std::string, jsvor::JsonSchemaPtr> schemas_;
-};
-
 typedef std::vector<jsvor::JsonSchemaPtr> JsonSchemas;
-typedef std::shared_ptr<SimpleResolver> SimpleResolverPtr;
+typedef std::shared_ptr<jsvor::SchemaRegistry> SchemaRegistryPtr;
 
 // Show error and help.
 template <typename Value>
@@ -93,12 +74,10 @@ std::string GetFileName(const std::string &file_path) {
 }
 
 jsvor::JsonSchemaPtr LoadSchema(const std::string &schema_path,
-                                const SimpleResolverPtr &resolver) {
+                                const SchemaRegistryPtr &registry) {
 	const std::string content = LoadFileContent(schema_path);
 	try {
-		auto schema = std::make_shared<jsvor::JsonSchema>(content, resolver);
-		resolver->AddSchema(GetFileName(schema_path), schema);
-		return schema;
+		return registry->Add(GetFileName(schema_path), content);
 	}
 	catch (const jsvor::Error &ex) {
 		ShowError("Could not load schema from ", schema_path, ": ", ex.what());
@@ -120,12 +99,12 @@ int main(int argc, char *argv[]) {
 	std::string json_path = argv[argc - 1];
 
 	// Load schemas.
-	auto resolver = std::make_shared<SimpleResolver>();
+	auto registry = std::make_shared<jsvor::SchemaRegistry>();
 
 	for (const auto& schema_path: schema_paths) {
-		LoadSchema(schema_path, resolver);
+		LoadSchema(schema_path, registry);
 	}
-	auto main_schema = LoadSchema(main_schema_path, resolver);
+	auto main_schema = LoadSchema(main_schema_path, registry);
 
 	// Load and validate file.
 	auto json = LoadFileContent(json_path);
@@ -0,0 +1,32 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "Defs.h"
+#include "RapidJsonDefs.h"
+
+namespace JsonSchemaValidator {
+
+// Validate elements of array starting from 'begin' by function 'validate' of element and context.
+// Elements of arrays larger than threshold of context are split into chunks validated by threads
+// of library pool with own results. Results are merged in order of elements and chunks after the
+// first stopped one are not needed, so errors are the same as on sequential validation.
+template <typename ValidateElement>
+void ValidateElements(JsonValue const &json, rapidjson::SizeType begin,
+                      ValidateElement const &validate, ValidationContext &context);
+
+} // namespace JsonSchemaValidator
+
+#include "ArrayElements.inl"
@@ -0,0 +1,83 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ArrayElements.h"
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+#include <JsonErrors.h>
+
+#include "ThreadPool.h"
+#include "ValidationContext.h"
+
+namespace JsonSchemaValidator {
+
+template <typename ValidateElement>
+void ValidateElementsInParallel(JsonValue const &json, rapidjson::SizeType begin,
+                                ValidateElement const &validate, ValidationContext &context) {
+	ThreadPool &pool = ThreadPool::Instance();
+	rapidjson::SizeType const count = json.Size() - begin;
+	// Several chunks for every worker allow to balance elements of different size.
+	size_t const chunks_count = std::min<size_t>(count, 4 * pool.GetWorkersCount());
+	std::vector<ValidationResult> results(chunks_count);
+	std::atomic<size_t> stopped_chunk(chunks_count);
+
+	TaskGroup group(pool);
+	for (size_t chunk = 0; chunk < chunks_count; ++chunk) {
+		group.Run([&, chunk] {
+			results[chunk].SetMaxErrors(context.GetResult().GetMaxErrors());
+			ValidationContext chunk_context(results[chunk], context.IsPathTracked());
+			chunk_context.SetParallelItemsThreshold(context.GetParallelItemsThreshold());
+
+			auto const first = static_cast<rapidjson::SizeType>(chunk * count / chunks_count);
+			auto const last = static_cast<rapidjson::SizeType>((chunk + 1) * count / chunks_count);
+			for (rapidjson::SizeType i = begin + first;
+			     i < begin + last && stopped_chunk.load(std::memory_order_relaxed) > chunk; ++i) {
+				ElementPathHolder path_holder(i, chunk_context);
+				validate(json[i], chunk_context);
+				if (chunk_context.IsFailed() && !chunk_context.Recover()) {
+					size_t stopped = stopped_chunk.load();
+					while (chunk < stopped &&
+					       !stopped_chunk.compare_exchange_weak(stopped, chunk)) {
+					}
+					return;
+				}
+			}
+		});
+	}
+	group.Wait();
+
+	for (auto const &result : results) {
+		context.Merge(result);
+		if (context.IsFailed() && !context.Recover()) return;
+	}
+}
+
+template <typename ValidateElement>
+void ValidateElements(JsonValue const &json, rapidjson::SizeType begin,
+                      ValidateElement const &validate, ValidationContext &context) {
+	size_t const threshold = context.GetParallelItemsThreshold();
+	if (threshold > 0 && json.Size() - begin > threshold) {
+		return ValidateElementsInParallel(json, begin, validate, context);
+	}
+	for (rapidjson::SizeType i = begin; i < json.Size(); ++i) {
+		ElementPathHolder path_holder(i, context);
+		validate(json[i], context);
+		if (context.IsFailed() && !context.Recover()) return;
+	}
+}
+
+} // namespace JsonSchemaValidator
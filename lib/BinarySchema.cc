@@ -0,0 +1,357 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BinarySchema.h"
+
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <JsonErrors.h>
+
+#include "RapidJsonHelpers.h"
+#include "SchemaProgram.h"
+
+namespace JsonSchemaValidator {
+
+namespace {
+
+char const kMagic[4] = { 'J', 'S', 'V', 'S' };
+// Version is changed on every incompatible change of format.
+uint32_t const kVersion = 2;
+uint32_t const kByteOrder = 0x01020304;
+
+enum ValueKind {
+	kNullValue,
+	kFalseValue,
+	kTrueValue,
+	kObjectValue,
+	kArrayValue,
+	kStringValue,
+	kInt64Value,
+	kUint64Value,
+	kDoubleValue
+}; // enum ValueKind
+
+struct Header {
+	char magic[4];
+	uint32_t version;
+	uint32_t byte_order;
+	uint32_t values_count;
+	uint64_t strings_offset;
+	uint64_t strings_size;
+	// Program follows strings, its size is zero if image has no program.
+	uint64_t program_offset;
+	uint64_t program_size;
+}; // struct Header
+
+// Size is count of members or elements of container or length of string. Payload is index of
+// the first child of container, offset of string in table of strings or value of number.
+struct Record {
+	uint32_t kind;
+	uint32_t size;
+	uint64_t payload;
+}; // struct Record
+
+Record ReadRecord(char const *data, size_t index) {
+	Record record;
+	memcpy(&record, data + sizeof(Header) + index * sizeof(Record), sizeof(record));
+	return record;
+}
+
+template <typename Type>
+uint64_t ToPayload(Type value) {
+	static_assert(sizeof(Type) == sizeof(uint64_t), "Payload must be 64-bit.");
+	uint64_t payload = 0;
+	memcpy(&payload, &value, sizeof(payload));
+	return payload;
+}
+
+template <typename Type>
+Type FromPayload(uint64_t payload) {
+	Type value;
+	memcpy(&value, &payload, sizeof(value));
+	return value;
+}
+
+} // namespace
+
+BinarySchema::BinarySchema(char const *data, size_t size, size_t mapped_size)
+	: data_(data)
+	, size_(size)
+	, mapped_size_(mapped_size)
+	, values_count_(0)
+	, strings_(nullptr)
+	, strings_size_(0)
+	, program_(nullptr)
+	, program_size_(0) {
+}
+
+BinarySchema::~BinarySchema() {
+	if (mapped_size_ > 0) {
+		munmap(const_cast<char *>(data_), mapped_size_);
+	}
+}
+
+std::shared_ptr<BinarySchema> BinarySchema::Map(char const *path) {
+	int file = open(path, O_RDONLY);
+	if (file < 0) {
+		throw IncorrectSchema(SchemaErrors::CantMapBinarySchema);
+	}
+	struct stat file_stat;
+	void *data = MAP_FAILED;
+	if (fstat(file, &file_stat) == 0 && file_stat.st_size > 0) {
+		data = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE,
+		            file, 0);
+	}
+	close(file);
+	if (data == MAP_FAILED) {
+		throw IncorrectSchema(SchemaErrors::CantMapBinarySchema);
+	}
+	size_t const size = static_cast<size_t>(file_stat.st_size);
+	std::shared_ptr<BinarySchema> schema(
+		new BinarySchema(static_cast<char const *>(data), size, size));
+	schema->ReadHeader();
+	return schema;
+}
+
+std::shared_ptr<BinarySchema> BinarySchema::Wrap(char const *image, size_t size) {
+	std::shared_ptr<BinarySchema> schema(new BinarySchema(image, size, 0));
+	schema->ReadHeader();
+	return schema;
+}
+
+void BinarySchema::Write(JsonValue const &schema, std::string &image) {
+	Write(schema, nullptr, image);
+}
+
+void BinarySchema::Write(JsonValue const &schema, SchemaProgram const &program,
+                         std::string &image) {
+	Write(schema, &program, image);
+}
+
+void BinarySchema::Write(JsonValue const &schema, SchemaProgram const *program,
+                         std::string &image) {
+	// Values are written in breadth-first order, so children of every container are consecutive.
+	std::vector<Record> records(1);
+	std::string strings;
+	std::vector<std::pair<JsonValue const *, size_t>> queue(1, std::make_pair(&schema, 0));
+	for (size_t i = 0; i < queue.size(); ++i) {
+		JsonValue const &value = *queue[i].first;
+		Record record = Record();
+		if (value.IsObject()) {
+			record.kind = kObjectValue;
+			record.size = value.MemberCount();
+			record.payload = records.size();
+			records.resize(records.size() + 2 * value.MemberCount());
+			size_t child = record.payload;
+			for (auto const &member : GetMembers(value)) {
+				queue.emplace_back(&member.name, child++);
+				queue.emplace_back(&member.value, child++);
+			}
+		}
+		else if (value.IsArray()) {
+			record.kind = kArrayValue;
+			record.size = value.Size();
+			record.payload = records.size();
+			records.resize(records.size() + value.Size());
+			for (JsonSizeType element = 0; element < value.Size(); ++element) {
+				queue.emplace_back(&value[element], record.payload + element);
+			}
+		}
+		else if (value.IsString()) {
+			record.kind = kStringValue;
+			record.size = value.GetStringLength();
+			record.payload = strings.size();
+			strings.append(value.GetString(), value.GetStringLength());
+			strings.push_back('\0');
+		}
+		else if (value.IsNumber()) {
+			if (value.IsDouble()) {
+				record.kind = kDoubleValue;
+				record.payload = ToPayload(value.GetDouble());
+			}
+			else if (value.IsInt64()) {
+				record.kind = kInt64Value;
+				record.payload = ToPayload(value.GetInt64());
+			}
+			else {
+				record.kind = kUint64Value;
+				record.payload = value.GetUint64();
+			}
+		}
+		else if (value.IsBool()) {
+			record.kind = value.GetBool() ? kTrueValue : kFalseValue;
+		}
+		else {
+			record.kind = kNullValue;
+		}
+		records[queue[i].second] = record;
+	}
+
+	std::string program_image;
+	if (program) {
+		std::unordered_map<JsonValue const *, uint32_t> value_records;
+		for (auto const &value : queue) {
+			value_records.insert({ value.first, static_cast<uint32_t>(value.second) });
+		}
+		program->Write(value_records, program_image);
+	}
+
+	Header header = Header();
+	memcpy(header.magic, kMagic, sizeof(kMagic));
+	header.version = kVersion;
+	header.byte_order = kByteOrder;
+	header.values_count = static_cast<uint32_t>(records.size());
+	header.strings_offset = sizeof(Header) + records.size() * sizeof(Record);
+	header.strings_size = strings.size();
+	header.program_offset = header.strings_offset + strings.size();
+	header.program_size = program_image.size();
+
+	image.clear();
+	image.reserve(header.program_offset + program_image.size());
+	image.append(reinterpret_cast<char const *>(&header), sizeof(header));
+	image.append(reinterpret_cast<char const *>(records.data()), records.size() * sizeof(Record));
+	image.append(strings);
+	image.append(program_image);
+}
+
+void BinarySchema::Read(JsonDocument &document) const {
+	document.SetNull();
+	ReadValue(0, document, document);
+}
+
+void BinarySchema::Read(size_t index, JsonValue &value, JsonDocument &document) const {
+	Check(index < values_count_);
+	ReadValue(index, value, document);
+}
+
+bool BinarySchema::HasProgram() const {
+	return program_size_ > 0;
+}
+
+char const *BinarySchema::GetProgram() const {
+	return program_;
+}
+
+size_t BinarySchema::GetProgramSize() const {
+	return program_size_;
+}
+
+void BinarySchema::Copy(std::string &image) const {
+	image.assign(data_, size_);
+}
+
+void BinarySchema::ReadHeader() {
+	Check(size_ >= sizeof(Header));
+	Header header;
+	memcpy(&header, data_, sizeof(header));
+	Check(memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion &&
+	      header.byte_order == kByteOrder && header.values_count > 0);
+	Check(header.strings_offset == sizeof(Header) + header.values_count * sizeof(Record) &&
+	      header.strings_offset <= size_ && header.strings_size <= size_ - header.strings_offset);
+	Check(header.program_offset == header.strings_offset + header.strings_size &&
+	      header.program_size == size_ - header.program_offset);
+
+	values_count_ = header.values_count;
+	strings_ = data_ + header.strings_offset;
+	strings_size_ = header.strings_size;
+	program_ = data_ + header.program_offset;
+	program_size_ = header.program_size;
+	CheckValues();
+}
+
+void BinarySchema::CheckValues() const {
+	// Containers are written in breadth-first order, so every container takes the next unused
+	// records as children. Otherwise records could be shared by several containers, and small
+	// corrupted image would be read as huge document, or records could be left unread.
+	uint64_t next_child = 1;
+	for (size_t index = 0; index < values_count_; ++index) {
+		Check(index < next_child);
+		Record const record = ReadRecord(data_, index);
+		if (record.kind == kObjectValue || record.kind == kArrayValue) {
+			Check(record.payload == next_child);
+			next_child += (record.kind == kObjectValue ? 2 : 1) * static_cast<uint64_t>(record.size);
+			Check(next_child <= values_count_);
+		}
+	}
+}
+
+void BinarySchema::ReadValue(size_t index, JsonValue &value, JsonDocument &document) const {
+	// Children of containers were checked by CheckValues, so every record is read once.
+	Record const record = ReadRecord(data_, index);
+	auto &allocator = document.GetAllocator();
+	switch (record.kind) {
+	case kNullValue:
+		value.SetNull();
+		break;
+	case kFalseValue:
+	case kTrueValue:
+		value.SetBool(record.kind == kTrueValue);
+		break;
+	case kObjectValue:
+		value.SetObject();
+		for (uint32_t i = 0; i < record.size; ++i) {
+			JsonValue name;
+			JsonValue member;
+			ReadValue(record.payload + 2 * i, name, document);
+			Check(name.IsString());
+			ReadValue(record.payload + 2 * i + 1, member, document);
+			value.AddMember(name, member, allocator);
+		}
+		break;
+	case kArrayValue:
+		value.SetArray();
+		value.Reserve(record.size, allocator);
+		for (uint32_t i = 0; i < record.size; ++i) {
+			JsonValue element;
+			ReadValue(record.payload + i, element, document);
+			value.PushBack(element, allocator);
+		}
+		break;
+	case kStringValue: {
+		Check(record.payload < strings_size_ && record.size < strings_size_ - record.payload);
+		char const *string = strings_ + record.payload;
+		Check(string[record.size] == '\0');
+		value.SetString(rapidjson::StringRef(string, record.size));
+		break;
+	}
+	case kInt64Value:
+		value.SetInt64(FromPayload<int64_t>(record.payload));
+		break;
+	case kUint64Value:
+		value.SetUint64(record.payload);
+		break;
+	case kDoubleValue:
+		value.SetDouble(FromPayload<double>(record.payload));
+		break;
+	default:
+		Check(false);
+	}
+}
+
+void BinarySchema::Check(bool condition) const {
+	if (!condition) {
+		throw IncorrectSchema(SchemaErrors::IncorrectBinarySchema);
+	}
+}
+
+} // namespace JsonSchemaValidator
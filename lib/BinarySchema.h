@@ -0,0 +1,84 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+#include <memory>
+
+#include "Defs.h"
+#include "RapidJsonDefs.h"
+
+namespace JsonSchemaValidator {
+
+class SchemaProgram;
+
+// Binary image of schema document. Image consists of header, array of fixed-size records of
+// values, table of strings and optional compiled program of schema (see SchemaProgram). Records
+// and strings are referred by offsets, so image contains no pointers and can be used directly from
+// mapped file. Children of container are stored in consecutive records (members of object as pairs
+// of name and value). Numbers are stored in byte order of writing machine, image written on
+// machine with other byte order is rejected.
+class BinarySchema {
+public:
+	// Image is mapped from file or refers to memory of caller, which must live while schema
+	// created from image is used.
+	static std::shared_ptr<BinarySchema> Map(char const *path);
+	static std::shared_ptr<BinarySchema> Wrap(char const *image, size_t size);
+	~BinarySchema();
+
+	BinarySchema(BinarySchema const &) = delete;
+	BinarySchema &operator=(BinarySchema const &) = delete;
+
+	static void Write(JsonValue const &schema, std::string &image);
+	// Program must be lowered from types of 'schema', values of its enums refer to records.
+	static void Write(JsonValue const &schema, SchemaProgram const &program, std::string &image);
+
+	// Strings of read document refer to image, they aren't copied. Exception 'IncorrectSchema'
+	// is thrown if image is corrupted or written by other version of library.
+	void Read(JsonDocument &document) const;
+	// Read value of record with given index (index of value in breadth-first order).
+	void Read(size_t index, JsonValue &value, JsonDocument &document) const;
+
+	bool HasProgram() const;
+	char const *GetProgram() const;
+	size_t GetProgramSize() const;
+	// Copy whole image.
+	void Copy(std::string &image) const;
+
+private:
+	BinarySchema(char const *data, size_t size, size_t mapped_size);
+
+	static void Write(JsonValue const &schema, SchemaProgram const *program, std::string &image);
+
+	void ReadHeader();
+	void CheckValues() const;
+	void ReadValue(size_t index, JsonValue &value, JsonDocument &document) const;
+	void Check(bool condition) const;
+
+	char const *data_;
+	size_t size_;
+	// Size of mapping, it's zero if memory belongs to caller.
+	size_t mapped_size_;
+
+	size_t values_count_;
+	char const *strings_;
+	size_t strings_size_;
+	char const *program_;
+	size_t program_size_;
+}; // class BinarySchema
+
+typedef std::shared_ptr<BinarySchema> BinarySchemaPtr;
+
+} // namespace JsonSchemaValidator
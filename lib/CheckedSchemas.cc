@@ -0,0 +1,107 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "CheckedSchemas.h"
+
+namespace JsonSchemaValidator {
+
+namespace {
+
+// Copy value with all its strings. Copy constructor of rapidjson value refers to constant strings
+// of source (e.g. strings of schema loaded from binary image), which can be destroyed.
+void CopyValue(JsonValue const &source, JsonValue &copy, JsonValue::AllocatorType &allocator) {
+	switch (source.GetType()) {
+	case rapidjson::kObjectType:
+		copy.SetObject();
+		for (auto const &member : GetMembers(source)) {
+			JsonValue name;
+			JsonValue value;
+			CopyValue(member.name, name, allocator);
+			CopyValue(member.value, value, allocator);
+			copy.AddMember(name, value, allocator);
+		}
+		break;
+	case rapidjson::kArrayType:
+		copy.SetArray();
+		copy.Reserve(source.Size(), allocator);
+		for (JsonSizeType i = 0; i < source.Size(); ++i) {
+			JsonValue element;
+			CopyValue(source[i], element, allocator);
+			copy.PushBack(element, allocator);
+		}
+		break;
+	case rapidjson::kStringType:
+		copy.SetString(source.GetString(), source.GetStringLength(), allocator);
+		break;
+	default:
+		copy.CopyFrom(source, allocator);
+		break;
+	}
+}
+
+} // namespace
+
+size_t const CheckedSchemas::kMaxSize;
+size_t const CheckedSchemas::kMaxBytes;
+
+CheckedSchemas::CheckedSchemas(size_t max_size, size_t max_bytes)
+	: max_size_(max_size)
+	, max_bytes_(max_bytes)
+	, mutex_()
+	, allocator_()
+	, schemas_()
+	, hashes_() {
+}
+
+bool CheckedSchemas::Contains(JsonValue const &schema) const {
+	size_t const hash = GetHash(schema);
+	std::lock_guard<std::mutex> lock(mutex_);
+	return Find(schema, hash);
+}
+
+void CheckedSchemas::Insert(JsonValue const &schema) {
+	size_t const hash = GetHash(schema);
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (schemas_.size() >= max_size_ || allocator_.Size() >= max_bytes_ || Find(schema, hash)) {
+		return;
+	}
+	schemas_.emplace_back();
+	CopyValue(schema, schemas_.back(), allocator_);
+	hashes_.insert({ hash, &schemas_.back() });
+}
+
+size_t CheckedSchemas::Size() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return schemas_.size();
+}
+
+CheckedSchemas &CheckedSchemas::Global() {
+	static CheckedSchemas checked_schemas(kMaxSize, kMaxBytes);
+	return checked_schemas;
+}
+
+bool CheckedSchemas::Find(JsonValue const &schema, size_t hash) const {
+	// Hash is consistent with IsEqual, and IsSame distinguishes integer and floating point
+	// numbers, which are checked differently by meta-schema.
+	auto range = hashes_.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it) {
+		if (IsSame(*it->second, schema)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace JsonSchemaValidator
@@ -0,0 +1,59 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+#include "RapidJsonHelpers.h"
+
+namespace JsonSchemaValidator {
+
+// Schemas validated by meta-schema, so equal schemas are validated once. Schemas are found by
+// hash and compared with copies of checked schemas, which share one allocator. Number and total
+// size of remembered schemas are limited, so process creating many different schemas doesn't run
+// out of memory: schemas checked after limit is reached are not remembered.
+class CheckedSchemas {
+public:
+	static size_t const kMaxSize = 4096;
+	static size_t const kMaxBytes = 4 * 1024 * 1024;
+
+	CheckedSchemas(size_t max_size, size_t max_bytes);
+
+	CheckedSchemas(CheckedSchemas const &) = delete;
+	CheckedSchemas &operator=(CheckedSchemas const &) = delete;
+
+	bool Contains(JsonValue const &schema) const;
+	void Insert(JsonValue const &schema);
+	size_t Size() const;
+
+	// Schemas checked by all schemas of process.
+	static CheckedSchemas &Global();
+
+private:
+	// Called with locked mutex_.
+	bool Find(JsonValue const &schema, size_t hash) const;
+
+	size_t max_size_;
+	size_t max_bytes_;
+	mutable std::mutex mutex_;
+	JsonValue::AllocatorType allocator_;
+	std::deque<JsonValue> schemas_;
+	std::unordered_multimap<size_t, JsonValue const *> hashes_;
+}; // class CheckedSchemas
+
+} // namespace JsonSchemaValidator
@@ -34,4 +34,9 @@ typedef std::function<JsonTypePtr(JsonValue const&, JsonResolverPtr const &,
 class Regex;
 typedef std::shared_ptr<Regex> RegexPtr;
 
+class RegexSet;
+typedef std::shared_ptr<RegexSet> RegexSetPtr;
+
+class NameSet;
+
 } // namespace JsonSchemaValidator
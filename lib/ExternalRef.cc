@@ -0,0 +1,117 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ExternalRef.h"
+
+#include <thread>
+
+#include <JsonSchema.h>
+#include <JsonResolver.h>
+
+#include "ValidationContext.h"
+
+namespace JsonSchemaValidator {
+
+struct ExternalRef::Binding {
+	std::weak_ptr<JsonSchema> schema;
+	JsonSchema const *target;
+}; // struct ExternalRef::Binding
+
+ExternalRef::ExternalRef(std::string const &ref, JsonResolverPtr const &resolver)
+	: ref_(ref)
+	, resolver_(resolver)
+	, binding_(nullptr)
+	, epoch_(0)
+	, readers_()
+	, epoch_mutex_() {
+}
+
+ExternalRef::~ExternalRef() {
+	delete binding_.load();
+}
+
+void ExternalRef::Link() const {
+	if (!binding_.load(std::memory_order_acquire)) {
+		Bind(nullptr);
+	}
+}
+
+void ExternalRef::Validate(JsonValue const &json, ValidationContext &context) const {
+	// Schema of pinned binding is alive, so the binding isn't replaced and can be read without
+	// counting of readers.
+	Binding *binding = binding_.load(std::memory_order_acquire);
+	if (binding && context.IsPinned(binding)) {
+		return binding->target->Validate(json, context);
+	}
+	// Lock keeps referenced schema alive during validation.
+	JsonSchemaPtr ref_schema = Lock(binding);
+	if (ref_schema && context.Pin(binding, ref_schema)) {
+		return ref_schema->Validate(json, context);
+	}
+	if (!ref_schema) {
+		// Reference isn't bound yet or bound schema has been destroyed.
+		ref_schema = Bind(binding);
+		if (!ref_schema) {
+			return;
+		}
+	}
+
+	// Schema isn't pinned, so result keeps it, if errors of its nodes are raised.
+	size_t const errors_count = context.GetErrorsCount();
+	ref_schema->Validate(json, context);
+	if (context.GetErrorsCount() != errors_count) {
+		context.GetResult().KeepSchema(ref_schema);
+	}
+}
+
+std::string const &ExternalRef::GetRef() const {
+	return ref_;
+}
+
+JsonSchemaPtr ExternalRef::Lock(Binding *&binding) const {
+	std::atomic<size_t> &readers = readers_[epoch_.load() & 1];
+	++readers;
+	binding = binding_.load();
+	JsonSchemaPtr ref_schema = binding ? binding->schema.lock() : JsonSchemaPtr();
+	--readers;
+	return ref_schema;
+}
+
+JsonSchemaPtr ExternalRef::Bind(Binding *bound) const {
+	JsonSchemaPtr ref_schema = resolver_->Resolve(ref_);
+	if (!ref_schema) {
+		return ref_schema;
+	}
+	std::unique_ptr<Binding> binding(new Binding{ ref_schema, ref_schema.get() });
+	// Reference could be bound by other thread, then its binding is used.
+	if (!binding_.compare_exchange_strong(bound, binding.get())) {
+		return ref_schema;
+	}
+	binding.release();
+	if (bound) {
+		std::lock_guard<std::mutex> lock(epoch_mutex_);
+		// Reader could read epoch before previous change and increment counter of other parity
+		// after it, so both parities are waited.
+		for (int i = 0; i < 2; ++i) {
+			size_t const parity = epoch_++ & 1;
+			while (readers_[parity].load() != 0) {
+				std::this_thread::yield();
+			}
+		}
+		delete bound;
+	}
+	return ref_schema;
+}
+
+} // namespace JsonSchemaValidator
@@ -0,0 +1,65 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "Defs.h"
+
+namespace JsonSchemaValidator {
+
+// Reference to schema resolved by resolver (not to subschema of the same document). Reference is
+// bound to resolved schema, so validation doesn't resolve it. Referenced schema isn't owned by
+// binding, because schemas can refer to each other. When bound schema is destroyed (e.g. replaced
+// in registry), reference is bound again. Bindings are replaced as in SRCU (see SchemaRegistry):
+// validation increments counter of current parity of epoch while it reads binding, and thread
+// which replaced binding waits until counters of both parities are zero, then previous binding is
+// freed.
+class ExternalRef {
+public:
+	ExternalRef(std::string const &ref, JsonResolverPtr const &resolver);
+	~ExternalRef();
+
+	ExternalRef(ExternalRef const &) = delete;
+	ExternalRef &operator=(ExternalRef const &) = delete;
+
+	// Bind reference if it can be resolved already, otherwise it's bound on first validation.
+	void Link() const;
+	void Validate(JsonValue const &json, ValidationContext &context) const;
+
+	std::string const &GetRef() const;
+
+private:
+	struct Binding;
+
+	// Return locked schema of current binding, binding is nullptr if reference isn't bound.
+	JsonSchemaPtr Lock(Binding *&binding) const;
+	JsonSchemaPtr Bind(Binding *bound) const;
+
+	std::string ref_;
+	JsonResolverPtr resolver_;
+	mutable std::atomic<Binding *> binding_;
+	mutable std::atomic<size_t> epoch_;
+	mutable std::atomic<size_t> readers_[2];
+	// Threads which replaced bindings change epoch one by one.
+	mutable std::mutex epoch_mutex_;
+}; // class ExternalRef
+
+typedef std::shared_ptr<ExternalRef> ExternalRefPtr;
+
+} // namespace JsonSchemaValidator
@@ -14,6 +14,9 @@
 
 #include "../include/JsonErrors.h"
 
+#include <cstring>
+#include <algorithm>
+
 #include "RapidJsonHelpers.h"
 
 namespace JsonSchemaValidator {
@@ -175,24 +178,210 @@ std::string TypeError::GetDescription() const {
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ValidationResult::ValidationResult()
-	: error_() {
+	: error_(DocumentErrors::None)
+	, type_(nullptr)
+	, name_(nullptr)
+	, max_errors_(1)
+	, errors_()
+	, path_size_(0)
+	, path_()
+	, deep_path_()
+	, names_()
+	, schemas_() {
+}
+
+void ValidationResult::SetMaxErrors(size_t count) {
+	max_errors_ = count;
+}
+
+size_t ValidationResult::GetMaxErrors() const {
+	return max_errors_;
+}
+
+void ValidationResult::AddError(DocumentErrors error, ErrorSource const *type,
+                                JsonValue const *instance, char const *name) {
+	if (max_errors_ > 1) {
+		if (errors_.size() >= max_errors_) {
+			return;
+		}
+		errors_.push_back(ValidationError{ error, type, instance, name, std::string() });
+		if (errors_.size() > 1) {
+			return;
+		}
+	}
+	error_ = error;
+	type_ = type;
+	name_ = name;
+	path_size_ = 0;
+	deep_path_.clear();
+}
+
+DocumentErrors ValidationResult::GetError() const {
+	return error_;
+}
+
+std::vector<ValidationError> const &ValidationResult::GetErrors() const {
+	return errors_;
+}
+
+void ValidationResult::Clear() {
+	error_ = DocumentErrors::None;
+	type_ = nullptr;
+	name_ = nullptr;
+	errors_.clear();
+	path_size_ = 0;
+	deep_path_.clear();
+	names_.reset();
+	schemas_.clear();
+}
+
+void ValidationResult::Append(ValidationResult const &result) {
+	if (result) {
+		return;
+	}
+	bool const first_error = error_ == DocumentErrors::None;
+	schemas_.insert(schemas_.end(), result.schemas_.begin(), result.schemas_.end());
+	if (max_errors_ > 1) {
+		for (auto const &error : result.errors_) {
+			if (errors_.size() >= max_errors_) {
+				break;
+			}
+			errors_.push_back(error);
+		}
+	}
+	if (first_error) {
+		error_ = result.error_;
+		type_ = result.type_;
+		name_ = result.name_;
+		path_size_ = 0;
+		deep_path_.clear();
+		for (size_t i = 0; i < result.path_size_; ++i) {
+			AddPath(result.GetPath(i));
+		}
+	}
 }
 
 std::string ValidationResult::ErrorDescription() const {
-	return error_ ? error_->GetDescription() : std::string();
+	DocumentErrorPtr error = CreateError();
+	return error ? error->GetDescription() : std::string();
 }
 
-void ValidationResult::AddPath(std::string const &path) {
-	if (error_) {
-		error_->AddPath(path);
+DocumentErrorPtr ValidationResult::CreateError() const {
+	if (error_ == DocumentErrors::None) {
+		return DocumentErrorPtr();
+	}
+	DocumentErrorPtr error = type_->CreateError(error_, name_ ? name_ : "");
+	for (size_t i = 0; i < path_size_; ++i) {
+		PathPart const &part = GetPath(i);
+		error->AddPath(part.member ? std::string(part.member)
+		                           : "[" + std::to_string(part.index) + "]");
+	}
+	return error;
+}
+
+void ValidationResult::AddPath(char const *member) {
+	AddPath(PathPart{ member, 0 });
+}
+
+void ValidationResult::AddPath(JsonSizeType index) {
+	AddPath(PathPart{ nullptr, index });
+}
+
+void ValidationResult::AddPath(PathPart const &part) {
+	if (error_ == DocumentErrors::None) {
+		return;
+	}
+	if (path_size_ < kInlinePathSize) {
+		path_[path_size_] = part;
+	}
+	else {
+		deep_path_.push_back(part);
+	}
+	++path_size_;
+}
+
+void ValidationResult::AddErrorsPath(char const *member, size_t first_error) {
+	// Member is escaped as reference token of JSON Pointer.
+	std::string part = "/";
+	for (char const *symbol = member; *symbol; ++symbol) {
+		part += (*symbol == '~') ? "~0" : (*symbol == '/') ? "~1" : std::string(1, *symbol);
+	}
+	for (size_t i = first_error; i < errors_.size(); ++i) {
+		errors_[i].path.insert(0, part);
+	}
+}
+
+void ValidationResult::AddErrorsPath(JsonSizeType index, size_t first_error) {
+	std::string const part = "/" + std::to_string(index);
+	for (size_t i = first_error; i < errors_.size(); ++i) {
+		errors_[i].path.insert(0, part);
+	}
+}
+
+ValidationResult::PathPart &ValidationResult::GetPath(size_t index) {
+	return index < kInlinePathSize ? path_[index] : deep_path_[index - kInlinePathSize];
+}
+
+ValidationResult::PathPart const &ValidationResult::GetPath(size_t index) const {
+	return index < kInlinePathSize ? path_[index] : deep_path_[index - kInlinePathSize];
+}
+
+void ValidationResult::DetachNames() {
+	size_t names_size = name_ ? strlen(name_) + 1 : 0;
+	for (size_t i = 0; i < path_size_; ++i) {
+		if (GetPath(i).member) {
+			names_size += strlen(GetPath(i).member) + 1;
+		}
+	}
+	for (auto const &error : errors_) {
+		if (error.name) {
+			names_size += strlen(error.name) + 1;
+		}
+	}
+	if (names_size == 0) {
+		return;
+	}
+
+	std::unique_ptr<char[]> names(new char[names_size]);
+	char *position = names.get();
+	auto detach = [&position](char const *&name) {
+		size_t const size = strlen(name) + 1;
+		name = static_cast<char const *>(memcpy(position, name, size));
+		position += size;
+	};
+	if (name_) {
+		detach(name_);
+	}
+	for (size_t i = 0; i < path_size_; ++i) {
+		PathPart &part = GetPath(i);
+		if (part.member) {
+			detach(part.member);
+		}
+	}
+	for (auto &error : errors_) {
+		if (error.name) {
+			detach(error.name);
+		}
+	}
+	names_ = std::move(names);
+}
+
+void ValidationResult::DetachInstances() {
+	for (auto &error : errors_) {
+		error.instance = nullptr;
+	}
+}
+
+void ValidationResult::KeepSchema(JsonSchemaPtr const &schema) {
+	if (std::find(schemas_.begin(), schemas_.end(), schema) == schemas_.end()) {
+		schemas_.push_back(schema);
 	}
 }
 
 ValidationResult::operator bool() const {
-	return !error_;
+	return error_ == DocumentErrors::None;
 }
 
-///////////////////////////////////////////////////////////////////////////////////////////////////
 char const *IncorrectSchema::what() const throw() {
 	switch (error_) {
 	case SchemaErrors::None:
@@ -216,6 +405,13 @@ char const *IncorrectSchema::what() const throw() {
 		return "Incorrect member value.";
 	case SchemaErrors::IncorrectDependencies:
 		return "Incorrect dependencies valu.e";
+	case SchemaErrors::IncorrectRef:
+		return "Incorrect local reference.";
+
+	case SchemaErrors::IncorrectBinarySchema:
+		return "Incorrect binary image of schema.";
+	case SchemaErrors::CantMapBinarySchema:
+		return "Cannot map file of binary schema.";
 
 	case SchemaErrors::Unknown:
 		return "Unknown error.";
@@ -227,11 +423,11 @@ char const *IncorrectSchema::what() const throw() {
 IncorrectDocument::IncorrectDocument(ValidationResult &&result)
 	: Error()
 	, result_(std::move(result))
-	, error_description_() {
+	, error_description_(result_.ErrorDescription()) {
+	// Description is created at once, because exception can outlive schema.
 }
 
 char const *IncorrectDocument::what() const throw() {
-	error_description_ = result_.ErrorDescription();
 	return error_description_.c_str();
 }
 
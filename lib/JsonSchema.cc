@@ -14,12 +14,25 @@
 
 #include "../include/JsonSchema.h"
 
+#include <vector>
 #include <memory>
 #include <string>
+#include <algorithm>
+#include <exception>
+
+#include <rapidjson/reader.h>
+#include <rapidjson/memorystream.h>
+#include <rapidjson/filereadstream.h>
 
 #include "../include/JsonResolver.h"
 
+#include "BinarySchema.h"
+#include "CheckedSchemas.h"
 #include "JsonType.h"
+#include "ReusableDocument.h"
+#include "SchemaProgram.h"
+#include "StreamValidator.h"
+#include "ThreadPool.h"
 #include "ValidationContext.h"
 
 namespace JsonSchemaValidator {
@@ -28,36 +41,46 @@ namespace {
 
 #include "CoreSchema.inl"
 
-class CoreSchemaResolver
-{
-public:
-	CoreSchemaResolver() {}
-	virtual ~CoreSchemaResolver() {}
+JsonSchemaPtr CreateCoreSchema() {
+	return std::make_shared<JsonSchema>(core_schema_draft03_desc);
+}
 
-	virtual JsonSchemaPtr Resolve(std::string const &ref) const {
-		return ref == "#" ? core_schema_ : JsonSchemaPtr();
-	}
+static JsonSchemaPtr core_schema_draft03 = CreateCoreSchema();
+
+JsonSchemaOptions MakeOptions(JsonResolverPtr const &resolver) {
+	JsonSchemaOptions options;
+	options.resolver = resolver;
+	return options;
+}
 
-	void SetCoreSchema(JsonSchemaPtr const& core_schema) {
-		core_schema_ = core_schema;
+void CheckSchema(JsonValue const &schema) {
+	if (CheckedSchemas::Global().Contains(schema)) {
+		return;
 	}
+	core_schema_draft03->Validate(schema);
+	CheckedSchemas::Global().Insert(schema);
+}
 
-private:
-	JsonSchemaPtr core_schema_;
-};
+void Parse(char const *document, JsonDocument &json) {
+	json.Parse<0>(document);
 
-JsonSchemaPtr CreateCoreSchema() {
-	auto resolver = std::make_shared<CoreSchemaResolver>();
-	auto schema = std::make_shared<JsonSchema>(core_schema_draft03_desc,
-	                                           std::dynamic_pointer_cast<JsonResolver>(resolver));
-	resolver->SetCoreSchema(schema);
-	return schema;
+	if (json.HasParseError()) {
+		throw IncorrectJson(GetLastError(json));
+	}
 }
 
-static JsonSchemaPtr core_schema_draft03 = CreateCoreSchema();
+void Parse(char const *document, size_t length, JsonDocument &json) {
+	rapidjson::MemoryStream stream(document, length);
+	json.ParseStream<0>(stream);
 
-void Parse(char const *document, JsonDocument &json) {
-	json.Parse<0>(document);
+	if (json.HasParseError()) {
+		throw IncorrectJson(GetLastError(json));
+	}
+}
+
+void ParseInsitu(char *document, size_t length, JsonDocument &json) {
+	InsituBufferStream stream(document, length);
+	json.ParseStream<rapidjson::kParseInsituFlag>(stream);
 
 	if (json.HasParseError()) {
 		throw IncorrectJson(GetLastError(json));
@@ -73,6 +96,66 @@ void Validate(JsonSchema const &schema, Document const &document) {
 	}
 }
 
+template <typename Document>
+void ValidateStream(JsonSchema const &schema, Document document) {
+	ValidationResult result;
+	schema.ValidateStream(document, result);
+	if (!result) {
+		throw IncorrectDocument(std::move(result));
+	}
+}
+
+template <typename Stream>
+void ParseStream(SchemaProgram const &program, Stream &stream, ValidationResult &result) {
+	result.Clear();
+	ValidationContext context(result);
+	StreamValidator validator(program, context);
+
+	rapidjson::Reader reader;
+	rapidjson::ParseResult parse_result = reader.Parse<0>(stream, validator);
+	if (!result) {
+		result.DetachNames();
+	}
+	if (!parse_result && (parse_result.Code() != rapidjson::kParseErrorTermination || result)) {
+		throw IncorrectJson(GetLastError(parse_result));
+	}
+}
+
+template <typename ParseDocument>
+void ValidateBatch(JsonSchema const &schema, size_t count, ParseDocument const &parse_document,
+                   ValidationResult *results) {
+	ThreadPool &pool = ThreadPool::Instance();
+	// Several tasks for every worker allow to balance documents of different size.
+	size_t const tasks_count = std::min(count, 4 * pool.GetWorkersCount());
+	std::vector<std::exception_ptr> errors(tasks_count);
+
+	TaskGroup group(pool);
+	for (size_t task = 0; task < tasks_count; ++task) {
+		group.Run([&, task] {
+			thread_local ReusableDocument document;
+			size_t const end = (task + 1) * count / tasks_count;
+			for (size_t i = task * count / tasks_count; i < end; ++i) {
+				try {
+					schema.Validate(parse_document(document, i), results[i]);
+					results[i].DetachInstances();
+				}
+				catch (...) {
+					if (!errors[task]) {
+						errors[task] = std::current_exception();
+					}
+				}
+			}
+		});
+	}
+	group.Wait();
+
+	for (auto const &error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+}
+
 } // namespace
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -91,45 +174,69 @@ SimpleResolver::~SimpleResolver() {
 }
 
 JsonSchemaPtr SimpleResolver::Resolve(std::string const &/*ref*/) const {
-	//TODO: Implement resolving of simple links.
+	// Local references are resolved by schema itself, other references need user resolver.
 	return JsonSchemaPtr();
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 struct JsonSchema::Impl {
+	// Strings of document loaded from binary image refer to the image.
+	BinarySchemaPtr binary_schema_;
 	JsonDocument schema_document_;
+	JsonValue const *schema_;
 
 	JsonResolverPtr resolver_;
-	JsonTypePtr root_object_;
+	// Linked tree of types lowered to flat program, which validates documents.
+	SchemaProgramPtr program_;
+	size_t parallel_items_threshold_;
 
 	Impl();
 }; // struct JsonSchema::Impl
 
 JsonSchema::Impl::Impl()
-	: schema_document_()
+	: binary_schema_()
+	, schema_document_()
+	, schema_(nullptr)
 	, resolver_(std::make_shared<SimpleResolver>())
-	, root_object_() {
+	, program_()
+	, parallel_items_threshold_(0) {
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
+JsonSchema::JsonSchema()
+	: impl_(std::make_shared<Impl>()) {
+}
+
 JsonSchema::JsonSchema(char const *schema, JsonResolverPtr const &resolver)
+	: JsonSchema(schema, MakeOptions(resolver)) {
+}
+
+JsonSchema::JsonSchema(std::string const &schema, JsonResolverPtr const &resolver)
+	: JsonSchema(schema, MakeOptions(resolver)) {
+}
+
+JsonSchema::JsonSchema(JsonValue const &schema, JsonResolverPtr const &resolver)
+	: JsonSchema(schema, MakeOptions(resolver)) {
+}
+
+JsonSchema::JsonSchema(char const *schema, JsonSchemaOptions const &options)
 	: impl_(std::make_shared<Impl>()) {
 
 	Parse(schema, impl_->schema_document_);
-	Initialize(impl_->schema_document_, resolver);
+	Initialize(impl_->schema_document_, options);
 }
 
-JsonSchema::JsonSchema(std::string const &schema, JsonResolverPtr const &resolver)
+JsonSchema::JsonSchema(std::string const &schema, JsonSchemaOptions const &options)
 	: impl_(std::make_shared<Impl>()) {
 
 	Parse(schema.c_str(), impl_->schema_document_);
-	Initialize(impl_->schema_document_, resolver);
+	Initialize(impl_->schema_document_, options);
 }
 
-JsonSchema::JsonSchema(JsonValue const &schema, JsonResolverPtr const &resolver)
+JsonSchema::JsonSchema(JsonValue const &schema, JsonSchemaOptions const &options)
 	: impl_(std::make_shared<Impl>()) {
 
-	Initialize(schema, resolver);
+	Initialize(schema, options);
 }
 
 void JsonSchema::Validate(char const *document) const {
@@ -140,6 +247,14 @@ void JsonSchema::Validate(std::string const &document) const {
 	JsonSchemaValidator::Validate(*this, document);
 }
 
+void JsonSchema::Validate(char const *document, size_t length) const {
+	ValidationResult result;
+	Validate(document, length, result);
+	if (!result) {
+		throw IncorrectDocument(std::move(result));
+	}
+}
+
 void JsonSchema::Validate(JsonValue const &document) const {
 	JsonSchemaValidator::Validate(*this, document);
 }
@@ -149,35 +264,174 @@ void JsonSchema::Validate(char const *document, ValidationResult &result) const
 
 	Parse(document, inspected_document);
 	Validate(inspected_document, result);
+	result.DetachInstances();
 }
 
 void JsonSchema::Validate(std::string const &document, ValidationResult &result) const {
-	Validate(document.c_str(), result);
+	Validate(document.data(), document.size(), result);
+}
+
+void JsonSchema::Validate(char const *document, size_t length, ValidationResult &result) const {
+	rapidjson::Document inspected_document;
+
+	Parse(document, length, inspected_document);
+	Validate(inspected_document, result);
+	result.DetachInstances();
 }
 
 void JsonSchema::Validate(JsonValue const &document, ValidationResult &result) const {
+	result.Clear();
 	ValidationContext context(result);
+	context.SetParallelItemsThreshold(impl_->parallel_items_threshold_);
 	Validate(document, context);
+	if (!result) {
+		result.DetachNames();
+	}
+}
+
+bool JsonSchema::IsValid(char const *document) const {
+	rapidjson::Document inspected_document;
+
+	Parse(document, inspected_document);
+	return IsValid(inspected_document);
+}
+
+bool JsonSchema::IsValid(std::string const &document) const {
+	return IsValid(document.data(), document.size());
+}
+
+bool JsonSchema::IsValid(char const *document, size_t length) const {
+	rapidjson::Document inspected_document;
+
+	Parse(document, length, inspected_document);
+	return IsValid(inspected_document);
+}
+
+bool JsonSchema::IsValid(JsonValue const &document) const {
+	ValidationResult result;
+	ValidationContext context(result, false);
+	context.SetParallelItemsThreshold(impl_->parallel_items_threshold_);
+	Validate(document, context);
+	return result;
+}
+
+void JsonSchema::ValidateInsitu(char *document, size_t length) const {
+	ValidationResult result;
+	ValidateInsitu(document, length, result);
+	if (!result) {
+		throw IncorrectDocument(std::move(result));
+	}
+}
+
+void JsonSchema::ValidateInsitu(char *document, size_t length, ValidationResult &result) const {
+	rapidjson::Document inspected_document;
+
+	ParseInsitu(document, length, inspected_document);
+	Validate(inspected_document, result);
+	result.DetachInstances();
+}
+
+void JsonSchema::ValidateStream(char const *document) const {
+	JsonSchemaValidator::ValidateStream(*this, document);
+}
+
+void JsonSchema::ValidateStream(std::FILE *document) const {
+	JsonSchemaValidator::ValidateStream(*this, document);
+}
+
+void JsonSchema::ValidateStream(char const *document, ValidationResult &result) const {
+	rapidjson::StringStream stream(document);
+	ParseStream(*impl_->program_, stream, result);
+}
+
+void JsonSchema::ValidateStream(std::FILE *document, ValidationResult &result) const {
+	char buffer[64 * 1024];
+	rapidjson::FileReadStream stream(document, buffer, sizeof(buffer));
+	ParseStream(*impl_->program_, stream, result);
+}
+
+void JsonSchema::ValidateBatch(char const *const *documents, size_t count,
+                               ValidationResult *results) const {
+	JsonSchemaValidator::ValidateBatch(*this, count,
+		[documents](ReusableDocument &document, size_t index) -> JsonValue const & {
+			return document.Parse(documents[index]);
+		}, results);
+}
+
+void JsonSchema::ValidateBatch(std::vector<std::string> const &documents,
+                               std::vector<ValidationResult> &results) const {
+	results.clear();
+	results.resize(documents.size());
+	JsonSchemaValidator::ValidateBatch(*this, documents.size(),
+		[&documents](ReusableDocument &document, size_t index) -> JsonValue const & {
+			return document.Parse(documents[index].data(), documents[index].size());
+		}, results.data());
 }
 
 void JsonSchema::Validate(JsonValue const &document, ValidationContext &context) const {
-	impl_->root_object_->Validate(document, context);
+	impl_->program_->Validate(document, context);
 }
 
-void JsonSchema::Initialize(JsonValue const &schema, JsonResolverPtr const &resolver) {
-	if ((!schema.HasMember("$schema") ||
+void JsonSchema::Save(std::string &image) const {
+	if (impl_->binary_schema_ && impl_->binary_schema_->HasProgram()) {
+		impl_->binary_schema_->Copy(image);
+		return;
+	}
+	BinarySchema::Write(*impl_->schema_, *impl_->program_, image);
+}
+
+JsonSchema JsonSchema::Load(char const *path, JsonResolverPtr const &resolver) {
+	JsonSchema schema;
+	schema.impl_->binary_schema_ = BinarySchema::Map(path);
+	schema.Initialize(resolver);
+	return schema;
+}
+
+JsonSchema JsonSchema::Load(char const *image, size_t size, JsonResolverPtr const &resolver) {
+	JsonSchema schema;
+	schema.impl_->binary_schema_ = BinarySchema::Wrap(image, size);
+	schema.Initialize(resolver);
+	return schema;
+}
+
+void JsonSchema::Initialize(JsonValue const &schema, JsonSchemaOptions const &options) {
+	if (!options.trusted && (!schema.HasMember("$schema") ||
 	     (schema.HasMember("$schema") && schema["$schema"].IsString() &&
 	      (schema["$schema"] == "http://json-schema.org/draft-03/schema#" ||
 	       schema["$schema"] == "http://json-schema.org/draft-03/schema"))) &&
 	    core_schema_draft03) {
 
-		core_schema_draft03->Validate(schema);
+		CheckSchema(schema);
+	}
+	if (options.resolver) {
+		impl_->resolver_ = options.resolver;
+	}
+	impl_->schema_ = &schema;
+	impl_->parallel_items_threshold_ = options.parallel_items_threshold;
+
+
+	// Tree of types is needed only for lowering.
+	SharedTypes shared_types;
+	JsonTypePtr root = JsonType::Create(schema, impl_->resolver_, "/");
+	LocalSchemas local_schemas(schema, root, impl_->resolver_);
+	root->Link(local_schemas);
+	impl_->program_.reset(new SchemaProgram(*root));
+}
+
+void JsonSchema::Initialize(JsonResolverPtr const &resolver) {
+	BinarySchema const &binary_schema = *impl_->binary_schema_;
+	if (!binary_schema.HasProgram()) {
+		// Image of document without program is compiled, saved schema was already validated by
+		// meta-schema.
+		binary_schema.Read(impl_->schema_document_);
+		JsonSchemaOptions options = MakeOptions(resolver);
+		options.trusted = true;
+		return Initialize(impl_->schema_document_, options);
 	}
 	if (resolver) {
 		impl_->resolver_ = resolver;
 	}
-
-	impl_->root_object_ = JsonType::Create(schema, impl_->resolver_, "/");
+	impl_->program_.reset(new SchemaProgram(binary_schema, impl_->resolver_));
 }
 
 } // namespace JsonSchemaValidator
@@ -14,16 +14,17 @@
 
 #include "JsonType.h"
 
+#include <map>
+#include <string>
 #include <functional>
 #include <algorithm>
-#include <map>
 
 
 #include <rapidjson/document.h>
+#include <rapidjson/pointer.h>
 
 #include "RapidJsonHelpers.h"
 #include "JsonSchema.h"
-#include "ValidationContext.h"
 #include "types/JsonTypeImpl.h"
 #include "types/PrimitiveTypes.h"
 #include "types/CustomTypes.h"
@@ -32,6 +33,12 @@ namespace JsonSchemaValidator {
 
 namespace {
 
+thread_local SharedTypes *current_shared_types = nullptr;
+
+void CombineHash(size_t &seed, size_t hash) {
+	seed ^= hash + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
 template <typename Type>
 JsonTypePtr MakeJsonType(JsonValue const &schema, JsonResolverPtr const &resolver,
                          std::string const &path) {
@@ -42,12 +49,16 @@ JsonTypePtr MakeJsonType(JsonValue const &schema, JsonResolverPtr const &resolve
 
 JsonType::JsonType(JsonValue const &schema, JsonResolverPtr const &resolver,
                    std::string const &path)
-	: required_(false)
-	, id_()
-	, path_(path)
-	, resolver_(resolver)
+	: value_kinds_(kAnyKind)
+	, checks_(kTypeRestrictionsCheck)
+	, required_(false)
 	, extends_()
-	, ref_() {
+	, local_ref_(nullptr)
+	, external_ref_()
+	, ref_()
+	, resolver_(resolver)
+	, id_()
+	, path_(path) {
 
 	//TODO: Check $schema.
 	GetChildValue(schema, "id", id_);
@@ -60,24 +71,16 @@ JsonType::JsonType(JsonValue const &schema, JsonResolverPtr const &resolver,
 			extends_.push_back(extended_type);
 		}
 	}
-}
 
-void JsonType::Validate(JsonValue const &json, ValidationContext &context) const {
-	ValidateRef(json, context);
-	if (context.GetResult()) {
-		ValidateExtends(json, context);
-	}
-	if (context.GetResult()) {
-		if (!CheckValueType(json)) {
-			RaiseError<TypeError>(context); //TODO: Specify required type
-		}
-	}
-	if (context.GetResult()) {
-		CheckEnumsRestrictions(json, context);
-	}
-	if (context.GetResult()) {
-		CheckTypeRestrictions(json, context);
+	if (ref_.exists && resolver_ && !IsLocalRef(ref_.value)) {
+		external_ref_ = std::make_shared<ExternalRef>(ref_.value, resolver_);
 	}
+
+	EnableCheck(kRefCheck, ref_.exists && resolver_);
+	EnableCheck(kExtendsCheck, !extends_.empty());
+}
+
+JsonType::~JsonType() {
 }
 
 bool JsonType::IsRequired() const
@@ -85,18 +88,39 @@ bool JsonType::IsRequired() const
 	return required_;
 }
 
-void JsonType::ValidateExtends(JsonValue const &json, ValidationContext &context) const {
-	for (auto const &json_type : extends_) {
-		json_type->Validate(json, context);
+void JsonType::Link(LocalSchemas &local_schemas) const {
+	if (external_ref_) {
+		external_ref_->Link();
+	}
+	else if ((checks_ & kRefCheck) && !local_ref_.load(std::memory_order_acquire)) {
+		JsonType const *unbound = nullptr;
+		local_ref_.compare_exchange_strong(unbound, &local_schemas.Get(ref_.value),
+		                                   std::memory_order_acq_rel);
+	}
+	ForEachChild([&local_schemas](JsonType const &child) {
+		child.Link(local_schemas);
+	});
+}
+
+void JsonType::ForEachChild(std::function<void (JsonType const &)> const &function) const {
+	for (auto const &extended_type : extends_) {
+		function(*extended_type);
 	}
 }
 
-void JsonType::ValidateRef(JsonValue const &json, ValidationContext &context) const {
-	if (ref_.exists && resolver_) {
-		JsonSchemaPtr ref_schema = resolver_->Resolve(ref_.value);
-		if (ref_schema) {
-			ref_schema->Validate(json, context);
-		}
+void JsonType::Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const {
+	node.kinds = value_kinds_;
+	JsonType const *local_ref = local_ref_.load(std::memory_order_acquire);
+	if (external_ref_) {
+		node.ref_kind = SchemaProgram::kExternalRef;
+		node.ref = builder.AddExternalRef(external_ref_);
+	}
+	else if ((checks_ & kRefCheck) && local_ref) {
+		node.ref_kind = SchemaProgram::kLocalRef;
+		node.ref = builder.AddNode(*local_ref);
+	}
+	if (checks_ & kExtendsCheck) {
+		node.extends = builder.AddNodes(extends_);
 	}
 }
 
@@ -106,13 +130,25 @@ JsonTypePtr JsonType::Create(JsonValue const &schema, JsonResolverPtr const &res
 		RaiseError(SchemaErrors::NotJsonObject);
 	}
 
+	SharedTypes *shared_types = SharedTypes::Current();
+	if (shared_types) {
+		JsonTypePtr shared_type = shared_types->Find(schema);
+		if (shared_type) {
+			return shared_type;
+		}
+	}
+
 	JsonValueMember const *type = FindMember(schema, "type");
 	JsonTypeCreator creator = type ? GetCreator(type->value) : MakeJsonType<JsonAny>;
 	if (!creator) {
 		RaiseError(SchemaErrors::CantDetectType);
 	}
 
-	return creator(schema, resolver, path);
+	JsonTypePtr created_type = creator(schema, resolver, path);
+	if (shared_types) {
+		shared_types->Insert(schema, created_type);
+	}
+	return created_type;
 }
 
 std::string JsonType::MemberPath(char const *member) const {
@@ -122,6 +158,18 @@ std::string JsonType::MemberPath(char const *member) const {
 	return (path_ + "/") + member;
 }
 
+void JsonType::SetValueKinds(unsigned kinds) {
+	value_kinds_ = static_cast<unsigned char>(kinds);
+}
+
+void JsonType::EnableCheck(Checks check, bool enable) {
+	checks_ = static_cast<unsigned char>(enable ? (checks_ | check) : (checks_ & ~check));
+}
+
+bool JsonType::IsCheckEnabled(Checks check) const {
+	return (checks_ & check) != 0;
+}
+
 JsonTypeCreator JsonType::GetCreator(JsonValue const &type) {
 	if (type.IsString()) {
 		static std::map<std::string, JsonTypeCreator> creators{
@@ -166,6 +214,116 @@ void JsonType::RaiseError(SchemaErrors error) {
 	throw IncorrectSchema(error);
 }
 
+bool JsonType::IsLocalRef(std::string const &ref) {
+	return !ref.empty() && ref[0] == '#';
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+LocalSchemas::LocalSchemas(JsonValue const &document, JsonTypePtr const &root,
+                           JsonResolverPtr const &resolver)
+	: document_(document)
+	, resolver_(resolver)
+	, types_({ { &document, root } }) {
+}
+
+JsonType const &LocalSchemas::Get(std::string const &ref) {
+	rapidjson::Pointer pointer(ref.c_str(), ref.size());
+	JsonValue const *value = pointer.IsValid() ? pointer.Get(document_) : nullptr;
+	if (!value) {
+		throw IncorrectSchema(SchemaErrors::IncorrectRef);
+	}
+
+	auto it = types_.find(value);
+	if (it != types_.end()) {
+		return *it->second;
+	}
+	// Type is cached before linking, so recursive references to it are bound to the same type.
+	JsonTypePtr type = JsonType::Create(*value, resolver_, ref.substr(1));
+	types_.insert({ value, type });
+	type->Link(*this);
+	return *type;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+SharedTypes::SharedTypes()
+	: previous_(current_shared_types)
+	, types_()
+	, hashes_() {
+	current_shared_types = this;
+}
+
+SharedTypes::~SharedTypes() {
+	current_shared_types = previous_;
+}
+
+JsonTypePtr SharedTypes::Find(JsonValue const &schema) {
+	auto range = types_.equal_range(Hash(schema));
+	for (auto it = range.first; it != range.second; ++it) {
+		if (IsSame(*it->second.first, schema)) {
+			return it->second.second;
+		}
+	}
+	return JsonTypePtr();
+}
+
+void SharedTypes::Insert(JsonValue const &schema, JsonTypePtr const &type) {
+	types_.insert({ Hash(schema), { &schema, type } });
+}
+
+SharedTypes *SharedTypes::Current() {
+	return current_shared_types;
+}
+
+size_t SharedTypes::Hash(JsonValue const &value) {
+	size_t hash = std::hash<int>()(value.GetType());
+	switch (value.GetType()) {
+	case rapidjson::kObjectType: {
+		auto it = hashes_.find(&value);
+		if (it != hashes_.end()) {
+			return it->second;
+		}
+		// Members are combined independently of their order.
+		size_t members_hash = 0;
+		for (auto member = value.MemberBegin(); member != value.MemberEnd(); ++member) {
+			size_t member_hash = Hash(member->name);
+			CombineHash(member_hash, Hash(member->value));
+			members_hash += member_hash;
+		}
+		CombineHash(hash, members_hash);
+		hashes_.insert({ &value, hash });
+		return hash;
+	}
+	case rapidjson::kArrayType: {
+		auto it = hashes_.find(&value);
+		if (it != hashes_.end()) {
+			return it->second;
+		}
+		for (JsonSizeType i = 0; i < value.Size(); ++i) {
+			CombineHash(hash, Hash(value[i]));
+		}
+		hashes_.insert({ &value, hash });
+		return hash;
+	}
+	case rapidjson::kStringType:
+		CombineHash(hash, std::hash<std::string>()(std::string(value.GetString(),
+		                                                       value.GetStringLength())));
+		return hash;
+	case rapidjson::kNumberType:
+		if (value.IsDouble()) {
+			CombineHash(hash, std::hash<double>()(value.GetDouble()));
+		}
+		else if (value.IsInt64()) {
+			CombineHash(hash, std::hash<long long>()(value.GetInt64()));
+		}
+		else {
+			CombineHash(hash, std::hash<unsigned long long>()(value.GetUint64()));
+		}
+		return hash;
+	default:
+		return hash;
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 bool GetValue(JsonValue const &json, JsonTypePtr &value, JsonResolverPtr const &resolver,
               std::string const &path) {
@@ -14,16 +14,23 @@
 
 #pragma once
 
+#include <map>
+#include <atomic>
 #include <vector>
+#include <unordered_map>
+#include <functional>
 
 #include <JsonErrors.h>
 
 #include "Defs.h"
+#include "ExternalRef.h"
 #include "RapidJsonHelpers.h"
-#include "ValidationContext.h"
+#include "SchemaProgram.h"
 
 namespace JsonSchemaValidator {
 
+class LocalSchemas;
+
 template <typename PropertyType>
 struct JsonTypeProperty {
 	JsonTypeProperty()
@@ -43,26 +50,34 @@ bool GetChildValue(JsonValue const &json, char const *child_name,
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
+// Type compiled from subschema. Linked tree of types is lowered to SchemaProgram, which validates
+// documents, so types are kept only while schema is compiled.
 class JsonType {
 public:
 	JsonType(JsonValue const &schema, JsonResolverPtr const &resolver, std::string const &path);
-	virtual ~JsonType() { }
-
-	virtual void Validate(JsonValue const &json, ValidationContext &context) const;
+	virtual ~JsonType();
 
 	bool IsRequired() const;
 
+	// Bind references of this type and of nested types to referenced schemas, so validation
+	// doesn't resolve them. Local references ("#/path/to/subschema") are bound to subschemas of
+	// schema document. Other references which can't be resolved yet (e.g. references to schemas
+	// which are not created yet) are bound on first validation.
+	void Link(LocalSchemas &local_schemas) const;
+
+	// Fill node of schema program (see SchemaProgram) by restrictions of this type. Nested and
+	// referenced types are lowered by builder, node refers to them by their indexes.
+	virtual void Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const;
+
 	static JsonTypePtr Create(JsonValue const &value, JsonResolverPtr const &resolver,
 	                          std::string const &path);
 
 protected:
 	std::string MemberPath(char const *member) const;
 
-	template <typename DocumentErrorType, typename... Args>
-	void RaiseError(ValidationContext &context, Args&&... args) const {
-		auto &result = context.GetResult();
-		result.SetError<DocumentErrorType>(args...);
-	}
+	// Call function for every type nested in this type (referenced schemas are not nested).
+	virtual void ForEachChild(std::function<void (JsonType const &)> const &function) const;
+
 	static void RaiseError(SchemaErrors error);
 	static JsonTypePtr CreateJsonTypeFromArrayElement(JsonValue const &schema,
 	                                                  JsonValue const &type,
@@ -70,24 +85,82 @@ protected:
 	                                                  std::string const &path);
 
 	static JsonTypeCreator GetCreator(JsonValue const &type);
+	static bool IsLocalRef(std::string const &ref);
 
-private:
-	void ValidateRef(JsonValue const &json, ValidationContext &context) const;
-	void ValidateExtends(JsonValue const &json, ValidationContext &context) const;
+	// Checks lowered to node of program. Subclasses disable checks which have nothing to do, so
+	// their nodes have no restrictions of these checks.
+	enum Checks {
+		kRefCheck = 1 << 0,
+		kExtendsCheck = 1 << 1,
+		kTypeRestrictionsCheck = 1 << 2
+	}; // enum Checks
 
-	virtual bool CheckValueType(JsonValue const &json) const = 0;
-	virtual void CheckTypeRestrictions(JsonValue const &json, ValidationContext &context) const = 0;
-	virtual void CheckEnumsRestrictions(JsonValue const &json, ValidationContext &context) const = 0;
+	void SetValueKinds(unsigned kinds);
+	void EnableCheck(Checks check, bool enable);
+	bool IsCheckEnabled(Checks check) const;
 
+private:
+	unsigned char value_kinds_;
+	unsigned char checks_;
 	bool required_;
-	std::string id_;
-	std::string path_;
-	JsonResolverPtr resolver_;
 	std::vector<JsonTypePtr> extends_;
+	// Local reference is bound to type of subschema on linking, shared type can be linked by
+	// several schemas, only the first binding is kept. Other references are external.
+	mutable std::atomic<JsonType const *> local_ref_;
+	ExternalRefPtr external_ref_;
 	JsonTypeProperty<std::string> ref_;
+	JsonResolverPtr resolver_;
+
+	std::string id_;
+	std::string path_;
 	// Properties schema, title, description, default not used for validation json-documents.
 }; // class JsonType
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Subschemas of schema document referred by local references. Every referred subschema is
+// compiled once and shared by all references to it.
+class LocalSchemas {
+public:
+	LocalSchemas(JsonValue const &document, JsonTypePtr const &root,
+	             JsonResolverPtr const &resolver);
+
+	// Return type of subschema referred by reference "#" or "#/path/to/subschema" (JSON Pointer
+	// in URI fragment representation), compile and link it on first request.
+	JsonType const &Get(std::string const &ref);
+
+private:
+	JsonValue const &document_;
+	JsonResolverPtr resolver_;
+	std::map<JsonValue const *, JsonTypePtr> types_;
+}; // class LocalSchemas
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Types compiled from subschemas of one schema. While object of this class exists, JsonType::Create
+// called in the same thread returns the same type for structurally equal subschemas, so repeated
+// subschemas are compiled once.
+class SharedTypes {
+public:
+	SharedTypes();
+	~SharedTypes();
+
+	SharedTypes(SharedTypes const &) = delete;
+	SharedTypes &operator=(SharedTypes const &) = delete;
+
+	JsonTypePtr Find(JsonValue const &schema);
+	void Insert(JsonValue const &schema, JsonTypePtr const &type);
+
+	// Innermost existing object in current thread or nullptr.
+	static SharedTypes *Current();
+
+private:
+	size_t Hash(JsonValue const &value);
+
+	SharedTypes *previous_;
+	std::unordered_multimap<size_t, std::pair<JsonValue const *, JsonTypePtr>> types_;
+	// Hashes of objects and arrays, they are computed once for nested values.
+	std::unordered_map<JsonValue const *, size_t> hashes_;
+}; // class SharedTypes
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 bool GetValue(JsonValue const &json, JsonTypePtr &value, JsonResolverPtr const &resolver,
               std::string const &path);
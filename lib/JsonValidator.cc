@@ -0,0 +1,88 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "../include/JsonValidator.h"
+
+#include "ReusableDocument.h"
+
+namespace JsonSchemaValidator {
+
+JsonValidator::JsonValidator(JsonSchema const &schema)
+	: schema_(schema)
+	, document_(new ReusableDocument()) {
+}
+
+JsonValidator::~JsonValidator() {
+}
+
+void JsonValidator::Validate(char const *document) {
+	ValidationResult result;
+	Validate(document, result);
+	if (!result) {
+		throw IncorrectDocument(std::move(result));
+	}
+}
+
+void JsonValidator::Validate(std::string const &document) {
+	Validate(document.data(), document.size());
+}
+
+void JsonValidator::Validate(char const *document, size_t length) {
+	ValidationResult result;
+	Validate(document, length, result);
+	if (!result) {
+		throw IncorrectDocument(std::move(result));
+	}
+}
+
+void JsonValidator::Validate(char const *document, ValidationResult &result) {
+	schema_.Validate(document_->Parse(document), result);
+	result.DetachInstances();
+}
+
+void JsonValidator::Validate(std::string const &document, ValidationResult &result) {
+	Validate(document.data(), document.size(), result);
+}
+
+void JsonValidator::Validate(char const *document, size_t length, ValidationResult &result) {
+	schema_.Validate(document_->Parse(document, length), result);
+	result.DetachInstances();
+}
+
+bool JsonValidator::IsValid(char const *document) {
+	return schema_.IsValid(document_->Parse(document));
+}
+
+bool JsonValidator::IsValid(std::string const &document) {
+	return IsValid(document.data(), document.size());
+}
+
+bool JsonValidator::IsValid(char const *document, size_t length) {
+	return schema_.IsValid(document_->Parse(document, length));
+}
+
+void JsonValidator::ValidateInsitu(char *document, size_t length) {
+	ValidationResult result;
+	ValidateInsitu(document, length, result);
+	if (!result) {
+		throw IncorrectDocument(std::move(result));
+	}
+}
+
+void JsonValidator::ValidateInsitu(char *document, size_t length, ValidationResult &result) {
+	schema_.Validate(document_->ParseInsitu(document, length), result);
+	result.DetachInstances();
+}
+
+} // namespace JsonSchemaValidator
@@ -0,0 +1,259 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "NameTable.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace JsonSchemaValidator {
+
+namespace {
+
+uint64_t const kMaxDisplacement = 1 << 16;
+
+uint64_t Hash(char const *name, size_t length, uint64_t seed) {
+	uint64_t hash = 14695981039346656037ULL ^ seed;
+	for (size_t i = 0; i < length; ++i) {
+		hash = (hash ^ static_cast<unsigned char>(name[i])) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+uint64_t Mix(uint64_t hash) {
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	return hash ^ (hash >> 33);
+}
+
+uint64_t PowerOfTwo(size_t value) {
+	uint64_t power = 1;
+	while (power < value) {
+		power <<= 1;
+	}
+	return power;
+}
+
+} // namespace
+
+size_t const NameTable::kNotFound;
+
+NameTable::NameTable()
+	: size_(0)
+	, seed_(0)
+	, buckets_mask_(0)
+	, slots_mask_(0)
+	, displacements_()
+	, slots_() {
+}
+
+NameTable::NameTable(std::vector<char const *> const &names)
+	: NameTable() {
+
+	size_ = names.size();
+	if (names.empty()) {
+		return;
+	}
+	// Different names can have equal hashes only for some seeds, so build with other seed succeeds.
+	while (!Build(names)) {
+		++seed_;
+	}
+}
+
+size_t NameTable::Find(char const *name, size_t length) const {
+	if (slots_.empty()) {
+		return kNotFound;
+	}
+	uint64_t hash = Hash(name, length, seed_);
+	Slot const &slot = slots_[Mix(hash ^ displacements_[hash & buckets_mask_]) & slots_mask_];
+	if (slot.length != length || !slot.name || std::memcmp(slot.name, name, length) != 0) {
+		return kNotFound;
+	}
+	return slot.index;
+}
+
+size_t NameTable::Size() const {
+	return size_;
+}
+
+std::vector<char const *> NameTable::GetNames() const {
+	std::vector<char const *> names(size_);
+	for (auto const &slot : slots_) {
+		if (slot.name) {
+			names[slot.index] = slot.name;
+		}
+	}
+	return names;
+}
+
+uint64_t NameTable::GetSeed() const {
+	return seed_;
+}
+
+std::vector<uint64_t> const &NameTable::GetDisplacements() const {
+	return displacements_;
+}
+
+std::vector<size_t> NameTable::GetSlots() const {
+	std::vector<size_t> slots;
+	for (auto const &slot : slots_) {
+		slots.push_back(slot.index);
+	}
+	return slots;
+}
+
+bool NameTable::Restore(std::vector<char const *> const &names, uint64_t seed,
+                        std::vector<uint64_t> const &displacements,
+                        std::vector<size_t> const &slots) {
+	*this = NameTable();
+	size_ = names.size();
+	if (names.empty()) {
+		return displacements.empty() && slots.empty();
+	}
+	if (displacements.empty() || PowerOfTwo(displacements.size()) != displacements.size() ||
+	    slots.empty() || PowerOfTwo(slots.size()) != slots.size()) {
+		return false;
+	}
+	seed_ = seed;
+	buckets_mask_ = displacements.size() - 1;
+	slots_mask_ = slots.size() - 1;
+	displacements_ = displacements;
+	slots_.assign(slots.size(), Slot{ nullptr, 0, kNotFound });
+	for (size_t i = 0; i < slots.size(); ++i) {
+		if (slots[i] == kNotFound) {
+			continue;
+		}
+		if (slots[i] >= names.size()) {
+			return false;
+		}
+		slots_[i] = Slot{ names[slots[i]], std::strlen(names[slots[i]]), slots[i] };
+	}
+	// Every name must be found by its own slot.
+	for (size_t i = 0; i < names.size(); ++i) {
+		if (Find(names[i], std::strlen(names[i])) != i) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool NameTable::Build(std::vector<char const *> const &names) {
+	buckets_mask_ = PowerOfTwo((names.size() + 1) / 2) - 1;
+	slots_mask_ = PowerOfTwo(2 * names.size()) - 1;
+	displacements_.assign(buckets_mask_ + 1, 0);
+	slots_.assign(slots_mask_ + 1, Slot{ nullptr, 0, kNotFound });
+
+	std::vector<uint64_t> hashes;
+	std::vector<std::vector<size_t>> buckets(buckets_mask_ + 1);
+	for (size_t i = 0; i < names.size(); ++i) {
+		hashes.push_back(Hash(names[i], std::strlen(names[i]), seed_));
+		buckets[hashes.back() & buckets_mask_].push_back(i);
+	}
+	// Large buckets are placed first, while there are many free slots.
+	std::vector<size_t> order;
+	for (size_t i = 0; i < buckets.size(); ++i) {
+		order.push_back(i);
+	}
+	std::stable_sort(order.begin(), order.end(), [&buckets](size_t left, size_t right) {
+		return buckets[left].size() > buckets[right].size();
+	});
+
+	std::vector<uint64_t> bucket_slots;
+	for (size_t bucket : order) {
+		bool placed = false;
+		for (uint64_t displacement = 0; !placed && displacement < kMaxDisplacement;
+		     ++displacement) {
+			bucket_slots.clear();
+			placed = true;
+			for (size_t index : buckets[bucket]) {
+				uint64_t slot = Mix(hashes[index] ^ displacement) & slots_mask_;
+				if (slots_[slot].name || std::find(bucket_slots.begin(), bucket_slots.end(),
+				                                   slot) != bucket_slots.end()) {
+					placed = false;
+					break;
+				}
+				bucket_slots.push_back(slot);
+			}
+			if (placed) {
+				displacements_[bucket] = displacement;
+				for (size_t i = 0; i < bucket_slots.size(); ++i) {
+					size_t index = buckets[bucket][i];
+					slots_[bucket_slots[i]] = Slot{ names[index], std::strlen(names[index]), index };
+				}
+			}
+		}
+		if (!placed) {
+			return false;
+		}
+	}
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+NameSet::NameSet(size_t names_count)
+	: local_words_()
+	, heap_words_()
+	, words_(local_words_) {
+
+	Reset(names_count);
+}
+
+void NameSet::Reset(size_t names_count) {
+	size_t words_count = (names_count + 63) / 64;
+	if (words_count > kLocalWords) {
+		heap_words_.assign(words_count, 0);
+		words_ = heap_words_.data();
+	}
+	else {
+		std::fill(local_words_, local_words_ + kLocalWords, 0);
+		words_ = local_words_;
+	}
+}
+
+void NameSet::Insert(size_t index) {
+	words_[index / 64] |= uint64_t(1) << (index % 64);
+}
+
+bool NameSet::Contains(size_t index) const {
+	return (words_[index / 64] & (uint64_t(1) << (index % 64))) != 0;
+}
+
+size_t NameSet::FindMissing(Mask const &mask) const {
+	return FindMissing(mask.data(), mask.size());
+}
+
+size_t NameSet::FindMissing(uint64_t const *mask, size_t words_count) const {
+	for (size_t word = 0; word < words_count; ++word) {
+		uint64_t missing = mask[word] & ~words_[word];
+		if (missing) {
+			size_t bit = 0;
+			while (!(missing & (uint64_t(1) << bit))) {
+				++bit;
+			}
+			return word * 64 + bit;
+		}
+	}
+	return NameTable::kNotFound;
+}
+
+void NameSet::AddToMask(Mask &mask, size_t index) {
+	if (mask.size() <= index / 64) {
+		mask.resize(index / 64 + 1);
+	}
+	mask[index / 64] |= uint64_t(1) << (index % 64);
+}
+
+} // namespace JsonSchemaValidator
@@ -0,0 +1,96 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace JsonSchemaValidator {
+
+// Table of names known in advance (e.g. properties of object schema) with perfect hashing: names
+// are distributed to buckets by hash and every bucket has displacement, which maps names of the
+// bucket to own slots. So lookup computes one hash and compares at most one name.
+class NameTable {
+public:
+	static size_t const kNotFound = static_cast<size_t>(-1);
+
+	NameTable();
+	// Names must be unique and must live while table is used.
+	explicit NameTable(std::vector<char const *> const &names);
+
+	// Return index of name in vector passed to constructor or kNotFound.
+	size_t Find(char const *name, size_t length) const;
+	size_t Size() const;
+
+	// Layout of built table: seed of hash, displacements of buckets and indexes of names in slots
+	// (kNotFound for free slots). Table restored from layout doesn't search for displacements.
+	std::vector<char const *> GetNames() const;
+	uint64_t GetSeed() const;
+	std::vector<uint64_t> const &GetDisplacements() const;
+	std::vector<size_t> GetSlots() const;
+	// Return false if layout doesn't describe table of names (e.g. it's read from corrupted image).
+	bool Restore(std::vector<char const *> const &names, uint64_t seed,
+	             std::vector<uint64_t> const &displacements, std::vector<size_t> const &slots);
+
+private:
+	struct Slot {
+		char const *name;
+		size_t length;
+		size_t index;
+	}; // struct Slot
+
+	bool Build(std::vector<char const *> const &names);
+
+	size_t size_;
+	uint64_t seed_;
+	uint64_t buckets_mask_;
+	uint64_t slots_mask_;
+	std::vector<uint64_t> displacements_;
+	std::vector<Slot> slots_;
+}; // class NameTable
+
+// Set of names of NameTable stored as bitset of their indexes. Masks of names (e.g. required
+// properties) are bitsets too, so set is checked against mask by words. Sets of up to
+// 64 * kLocalWords names don't allocate memory.
+class NameSet {
+public:
+	typedef std::vector<uint64_t> Mask;
+
+	explicit NameSet(size_t names_count);
+
+	NameSet(NameSet const &) = delete;
+	NameSet &operator=(NameSet const &) = delete;
+
+	// Remove all names and prepare set for names of other table.
+	void Reset(size_t names_count);
+
+	void Insert(size_t index);
+	bool Contains(size_t index) const;
+	// Return the least index of mask which isn't contained in set or NameTable::kNotFound.
+	size_t FindMissing(Mask const &mask) const;
+	size_t FindMissing(uint64_t const *mask, size_t words_count) const;
+
+	static void AddToMask(Mask &mask, size_t index);
+
+private:
+	static size_t const kLocalWords = 4;
+
+	uint64_t local_words_[kLocalWords];
+	std::vector<uint64_t> heap_words_;
+	uint64_t *words_;
+}; // class NameSet
+
+} // namespace JsonSchemaValidator
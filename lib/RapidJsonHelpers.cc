@@ -15,6 +15,7 @@
 #include "RapidJsonHelpers.h"
 
 #include <sstream>
+#include <algorithm>
 
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
@@ -99,6 +100,67 @@ JsonNullValue::JsonNullValue(JsonValue const &value)
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace {
+
+bool IsEqualStrings(JsonValue const &left, JsonValue const &right) {
+	return left.GetStringLength() == right.GetStringLength() &&
+		memcmp(left.GetString(), right.GetString(), left.GetStringLength()) == 0;
+}
+
+// Order of member names by length and then by bytes, it's cheaper than lexicographical order,
+// because names of different length are compared without access to their characters.
+bool IsLessName(JsonValueMember const *left, JsonValueMember const *right) {
+	JsonSizeType const left_length = left->name.GetStringLength();
+	JsonSizeType const right_length = right->name.GetStringLength();
+	if (left_length != right_length) {
+		return left_length < right_length;
+	}
+	return memcmp(left->name.GetString(), right->name.GetString(), left_length) < 0;
+}
+
+void SortMembers(JsonValue const &object, JsonValueMember const **members) {
+	JsonValueMember const **member = members;
+	for (auto const &value : GetMembers(object)) {
+		*member++ = &value;
+	}
+	std::sort(members, member, IsLessName);
+}
+
+// Members are compared pairwise in order of their names, so comparison doesn't depend on order of
+// members and objects with duplicated names are compared consistently with GetHash.
+bool IsEqualObjects(JsonValue const &left, JsonValue const &right) {
+	if (left.MemberCount() != right.MemberCount()) {
+		return false;
+	}
+
+	// Members of small objects are sorted on stack without allocations.
+	JsonSizeType const kMaxStackSize = 16;
+	JsonValueMember const *stack_members[2 * kMaxStackSize];
+	std::vector<JsonValueMember const *> heap_members;
+	JsonValueMember const **left_members = stack_members;
+	if (left.MemberCount() > kMaxStackSize) {
+		heap_members.resize(2 * left.MemberCount());
+		left_members = heap_members.data();
+	}
+	JsonValueMember const **right_members = left_members + left.MemberCount();
+	SortMembers(left, left_members);
+	SortMembers(right, right_members);
+
+	for (JsonSizeType i = 0; i < left.MemberCount(); ++i) {
+		if (!IsEqualStrings(left_members[i]->name, right_members[i]->name)) {
+			return false;
+		}
+	}
+	for (JsonSizeType i = 0; i < left.MemberCount(); ++i) {
+		if (!IsEqual(left_members[i]->value, right_members[i]->value)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace
+
 bool IsEqual(JsonValue const &left, JsonValue const &right) {
 	if (left.GetType() != right.GetType()) {
 		return false;
@@ -106,19 +168,7 @@ bool IsEqual(JsonValue const &left, JsonValue const &right) {
 
 	using namespace rapidjson;
 	if (left.IsObject()) {
-		for (auto const &member : GetMembers(left)) {
-			JsonValueMember const *it = FindMember(right, GetValue<char const *>(member.name));
-			if (!it || !IsEqual(member.value, it->value)) {
-				return false;
-			}
-		}
-		for (auto const &member : GetMembers(right)) {
-			JsonValueMember const *it = FindMember(left, GetValue<char const *>(member.name));
-			if (!it) {
-				return false;
-			}
-		}
-		return true;
+		return IsEqualObjects(left, right);
 	}
 	if (left.IsArray()) {
 		if (left.Size() != right.Size()) {
@@ -132,26 +182,136 @@ bool IsEqual(JsonValue const &left, JsonValue const &right) {
 		return true;
 	}
 	if (left.IsString()) {
-		return strcmp(GetValue<char const *>(left), GetValue<char const *>(right)) == 0;
+		return IsEqualStrings(left, right);
 	}
 	if (left.IsNumber()) {
-		if (!left.IsDouble() && !right.IsDouble()) {
-			return GetValue<long long>(left) == GetValue<long long>(right);
+		// Numbers are compared exactly, integer and double are equal if they have equal values
+		// as doubles (e.g. 1 and 1.0).
+		if (left.IsInt64() && right.IsInt64()) {
+			return left.GetInt64() == right.GetInt64();
+		}
+		if (left.IsUint64() && right.IsUint64()) {
+			return left.GetUint64() == right.GetUint64();
+		}
+		return left.GetDouble() == right.GetDouble();
+	}
+	// Types are equal, so null, true and false values are equal too.
+	return true;
+}
+
+bool IsSame(JsonValue const &first, JsonValue const &second) {
+	if (first.GetType() != second.GetType()) {
+		return false;
+	}
+	switch (first.GetType()) {
+	case rapidjson::kObjectType:
+		if (first.MemberCount() != second.MemberCount()) {
+			return false;
+		}
+		for (auto it = first.MemberBegin(); it != first.MemberEnd(); ++it) {
+			auto found = second.FindMember(it->name);
+			if (found == second.MemberEnd() || !IsSame(it->value, found->value)) {
+				return false;
+			}
+		}
+		return true;
+	case rapidjson::kArrayType:
+		if (first.Size() != second.Size()) {
+			return false;
+		}
+		for (JsonSizeType i = 0; i < first.Size(); ++i) {
+			if (!IsSame(first[i], second[i])) {
+				return false;
+			}
+		}
+		return true;
+	case rapidjson::kNumberType:
+		if (first.IsDouble() || second.IsDouble()) {
+			return first.IsDouble() && second.IsDouble() && first.GetDouble() == second.GetDouble();
 		}
-		return std::fabs(GetValue<double>(left) -GetValue<double>(right)) <
-			std::numeric_limits<double>::epsilon();
+		return first == second;
+	default:
+		return first == second;
+	}
+}
+
+size_t GetHash(JsonValue const &value) {
+	size_t hash = std::hash<int>()(value.GetType());
+	auto combine = [&hash](size_t value_hash) {
+		hash ^= value_hash + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	};
+
+	if (value.IsObject()) {
+		size_t members_hash = 0;
+		for (auto const &member : GetMembers(value)) {
+			members_hash += GetHash(member.name) * 31 + GetHash(member.value);
+		}
+		combine(members_hash);
+	}
+	else if (value.IsArray()) {
+		for (JsonSizeType i = 0; i < value.Size(); ++i) {
+			combine(GetHash(value[i]));
+		}
+	}
+	else if (value.IsString()) {
+		combine(std::hash<std::string>()(std::string(value.GetString(), value.GetStringLength())));
+	}
+	else if (value.IsNumber()) {
+		// Numbers equal by IsEqual have equal values as doubles, -0.0 is equal to 0.0.
+		double const number = value.GetDouble();
+		combine(std::hash<double>()(number == 0.0 ? 0.0 : number));
 	}
-	if (left.IsBool()) {
+	return hash;
+}
+
+bool HasUniqueElements(JsonValue const &array) {
+	// Small arrays are checked by comparing of every pair of elements without allocations.
+	JsonSizeType const kMaxPairwiseSize = 8;
+	if (array.Size() <= kMaxPairwiseSize) {
+		for (JsonSizeType i = 0; i + 1 < array.Size(); ++i) {
+			for (JsonSizeType j = i + 1; j < array.Size(); ++j) {
+				if (IsEqual(array[i], array[j])) {
+					return false;
+				}
+			}
+		}
 		return true;
 	}
-	return false;
+
+	JsonValueSet elements;
+	for (JsonSizeType i = 0; i < array.Size(); ++i) {
+		if (!elements.Insert(array[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+JsonValueSet::JsonValueSet()
+	: values_() {
+}
+
+bool JsonValueSet::Insert(JsonValue const &value) {
+	return values_.insert(&value).second;
+}
+
+bool JsonValueSet::Contains(JsonValue const &value) const {
+	return values_.find(&value) != values_.end();
+}
+
+std::vector<JsonValue const *> JsonValueSet::GetValues() const {
+	return std::vector<JsonValue const *>(values_.begin(), values_.end());
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 std::string GetLastError(JsonDocument const &json) {
+	return GetLastError(rapidjson::ParseResult(json.GetParseError(), json.GetErrorOffset()));
+}
+
+std::string GetLastError(rapidjson::ParseResult const &result) {
 	std::stringstream error;
-	error << "Error at " << json.GetErrorOffset() << ": "
-	      << rapidjson::GetParseError_En(json.GetParseError());
+	error << "Error at " << result.Offset() << ": " << rapidjson::GetParseError_En(result.Code());
 	return error.str();
 }
 
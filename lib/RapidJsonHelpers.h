@@ -23,6 +23,7 @@
 #include <ostream>
 #include <sstream>
 #include <functional>
+#include <unordered_set>
 
 #include "RapidJsonDefs.h"
 
@@ -41,6 +42,84 @@ MemberRange GetMembers(JsonValue const &json);
 
 JsonValueMember const *FindMember(JsonValue const &json, char const *child_name);
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Kinds of json-values in terms of json-schema, used as bits of masks of allowed kinds.
+enum JsonValueKind {
+	kNullKind = 1 << 0,
+	kBooleanKind = 1 << 1,
+	kObjectKind = 1 << 2,
+	kArrayKind = 1 << 3,
+	kStringKind = 1 << 4,
+	kIntegerKind = 1 << 5,
+	kDoubleKind = 1 << 6,
+
+	kNumberKind = kIntegerKind | kDoubleKind,
+	kAnyKind = kNullKind | kBooleanKind | kObjectKind | kArrayKind | kStringKind | kNumberKind
+}; // enum JsonValueKind
+
+inline JsonValueKind GetValueKind(JsonValue const &json) {
+	switch (json.GetType()) {
+	case rapidjson::kNullType:
+		return kNullKind;
+	case rapidjson::kFalseType:
+	case rapidjson::kTrueType:
+		return kBooleanKind;
+	case rapidjson::kObjectType:
+		return kObjectKind;
+	case rapidjson::kArrayType:
+		return kArrayKind;
+	case rapidjson::kStringType:
+		return kStringKind;
+	case rapidjson::kNumberType:
+		return json.IsDouble() ? kDoubleKind : kIntegerKind;
+	}
+	return kNullKind;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Stream for in-situ parsing of buffer with known length, the buffer needn't be terminated by
+// zero. Decoded strings are written over source text and they are not longer than source text,
+// so parser never writes outside of the buffer.
+class InsituBufferStream {
+public:
+	typedef char Ch;
+
+	InsituBufferStream(char *buffer, size_t length)
+		: source_(buffer)
+		, destination_(nullptr)
+		, begin_(buffer)
+		, end_(buffer + length) {
+	}
+
+	Ch Peek() const {
+		return source_ != end_ ? *source_ : '\0';
+	}
+	Ch Take() {
+		return source_ != end_ ? *source_++ : '\0';
+	}
+	size_t Tell() const {
+		return static_cast<size_t>(source_ - begin_);
+	}
+
+	Ch *PutBegin() {
+		return destination_ = source_;
+	}
+	void Put(Ch symbol) {
+		*destination_++ = symbol;
+	}
+	size_t PutEnd(Ch *begin) {
+		return static_cast<size_t>(destination_ - begin);
+	}
+	void Flush() {
+	}
+
+private:
+	char *source_;
+	char *destination_;
+	char *begin_;
+	char *end_;
+}; // class InsituBufferStream
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 class BasicJsonValue {
 public:
@@ -272,10 +351,49 @@ struct StrLess {
 	}
 }; // struct StrLess
 
+// Deep comparison of json-values, members of objects are compared independently of their order,
+// strings (and names of members) are compared with their lengths.
 bool IsEqual(JsonValue const &left, JsonValue const &right);
+// Unlike IsEqual, integer and floating point numbers are different (e.g. 1 and 1.0), because
+// schema can be interpreted differently for them.
+bool IsSame(JsonValue const &first, JsonValue const &second);
+// Hash consistent with IsEqual: equal values have equal hashes, members of objects are hashed
+// independently of their order.
+size_t GetHash(JsonValue const &value);
+// Check whether array has no elements equal by IsEqual.
+bool HasUniqueElements(JsonValue const &array);
+
+// Set of json-values (e.g. elements of enum) compared by IsEqual. Values aren't copied, so they
+// must live while set is used.
+class JsonValueSet {
+public:
+	JsonValueSet();
+
+	// Return false if equal value is already contained in set.
+	bool Insert(JsonValue const &value);
+	bool Contains(JsonValue const &value) const;
+	// Values of set in arbitrary order.
+	std::vector<JsonValue const *> GetValues() const;
+
+private:
+	struct Hash {
+		size_t operator()(JsonValue const *value) const {
+			return GetHash(*value);
+		}
+	}; // struct Hash
+
+	struct Equal {
+		bool operator()(JsonValue const *left, JsonValue const *right) const {
+			return IsEqual(*left, *right);
+		}
+	}; // struct Equal
+
+	std::unordered_set<JsonValue const *, Hash, Equal> values_;
+}; // class JsonValueSet
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 std::string GetLastError(JsonDocument const &json);
+std::string GetLastError(rapidjson::ParseResult const &result);
 std::string ToString(JsonValue const &value);
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
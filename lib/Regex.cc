@@ -15,6 +15,9 @@
 #include "Regex.h"
 
 #include <memory>
+#include <algorithm>
+
+#include "NameTable.h"
 
 namespace JsonSchemaValidator {
 
@@ -29,6 +32,17 @@ char const *Regex::Pattern() const {
 	return pattern_.c_str();
 }
 
+RegexSet::RegexSet(std::vector<char const *> const &patterns)
+	: patterns_(patterns.begin(), patterns.end()) {
+}
+
+RegexSet::~RegexSet() {
+}
+
+std::vector<std::string> const &RegexSet::Patterns() const {
+	return patterns_;
+}
+
 } // namespace JsonSchemaValidator
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -68,11 +82,51 @@ RegexPtr Regex::Create(char const *pattern) {
 	return std::make_shared<StdRegex>(pattern);
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// std::regex can't search several patterns at once, so they are searched one by one.
+class StdRegexSet : public RegexSet {
+public:
+	StdRegexSet(std::vector<char const *> const &patterns);
+	virtual ~StdRegexSet();
+
+	void Match(char const *value, size_t length, NameSet &matches) const;
+
+private:
+	std::vector<std::regex> impl_;
+}; // class StdRegexSet : public RegexSet
+
+StdRegexSet::StdRegexSet(std::vector<char const *> const &patterns)
+	: RegexSet(patterns)
+	, impl_(patterns.begin(), patterns.end()) {
+}
+
+StdRegexSet::~StdRegexSet() {
+}
+
+void StdRegexSet::Match(char const *value, size_t length, NameSet &matches) const {
+	matches.Reset(impl_.size());
+	for (size_t i = 0; i < impl_.size(); ++i) {
+		if (std::regex_search(value, value + length, impl_[i])) {
+			matches.Insert(i);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+RegexSetPtr RegexSet::Create(std::vector<char const *> const &patterns) {
+	return std::make_shared<StdRegexSet>(patterns);
+}
+
 } // namespace JsonSchemaValidator
 
 #else // defined(USE_STD_REGEX)
 
+#include <mutex>
+
 #include <re2/re2.h>
+#include <re2/set.h>
 
 namespace JsonSchemaValidator {
 
@@ -105,6 +159,81 @@ RegexPtr Regex::Create(char const *pattern) {
 	return std::make_shared<Re2Regex>(pattern);
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class Re2RegexSet : public RegexSet {
+public:
+	Re2RegexSet(std::vector<char const *> const &patterns);
+	virtual ~Re2RegexSet();
+
+	void Match(char const *value, size_t length, NameSet &matches) const;
+
+private:
+	re2::RE2::Set impl_;
+	// Indexes of patterns added to set (incorrect patterns are not added and never match).
+	std::vector<int> indexes_;
+	// Patterns are searched one by one if set can't be matched (e.g. its DFA exceeds memory limit).
+	// It happens rarely, so they are compiled on first use.
+	mutable std::once_flag fallback_flag_;
+	mutable std::vector<std::unique_ptr<re2::RE2>> fallback_;
+}; // class Re2RegexSet : public RegexSet
+
+Re2RegexSet::Re2RegexSet(std::vector<char const *> const &patterns)
+	: RegexSet(patterns)
+	, impl_(RE2::DefaultOptions, RE2::UNANCHORED)
+	, indexes_()
+	, fallback_flag_()
+	, fallback_() {
+
+	for (size_t i = 0; i < patterns.size(); ++i) {
+		if (impl_.Add(patterns[i], nullptr) >= 0) {
+			indexes_.push_back(static_cast<int>(i));
+		}
+	}
+	if (!impl_.Compile()) {
+		indexes_.clear();
+	}
+}
+
+Re2RegexSet::~Re2RegexSet() {
+}
+
+void Re2RegexSet::Match(char const *value, size_t length, NameSet &matches) const {
+	matches.Reset(Patterns().size());
+	re2::StringPiece const text(value, length);
+	if (!indexes_.empty()) {
+		// Indexes of set are used only inside of this call, so buffer is reused by thread.
+		thread_local std::vector<int> set_matches;
+		RE2::Set::ErrorInfo error;
+		if (impl_.Match(text, &set_matches, &error)) {
+			for (int match : set_matches) {
+				matches.Insert(indexes_[match]);
+			}
+			return;
+		}
+		if (error.kind == RE2::Set::kNoError) {
+			return;
+		}
+	}
+
+	std::call_once(fallback_flag_, [this] {
+		for (auto const &pattern : Patterns()) {
+			fallback_.emplace_back(new re2::RE2(pattern));
+		}
+	});
+	for (size_t i = 0; i < fallback_.size(); ++i) {
+		if (RE2::PartialMatch(text, *fallback_[i])) {
+			matches.Insert(i);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+RegexSetPtr RegexSet::Create(std::vector<char const *> const &patterns) {
+	return std::make_shared<Re2RegexSet>(patterns);
+}
+
 } // namespace JsonSchemaValidator
 
 #endif // defined(USE_STD_REGEX)
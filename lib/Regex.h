@@ -15,6 +15,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "Defs.h"
 
@@ -36,4 +37,23 @@ private:
 	std::string pattern_;
 }; // class Regex
 
+// Set of regular expressions which are searched in value together, so value is scanned once for
+// all of them.
+class RegexSet {
+public:
+	explicit RegexSet(std::vector<char const *> const &patterns);
+	virtual ~RegexSet();
+
+	// Put indexes of found patterns to 'matches', which is reset for all patterns of set. Sets of
+	// usual size don't allocate memory, so matches can be kept on stack for every object.
+	virtual void Match(char const *value, size_t length, NameSet &matches) const = 0;
+
+	std::vector<std::string> const &Patterns() const;
+
+	static RegexSetPtr Create(std::vector<char const *> const &patterns);
+
+private:
+	std::vector<std::string> patterns_;
+}; // class RegexSet
+
 } // namespace JsonSchemaValidator
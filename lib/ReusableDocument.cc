@@ -0,0 +1,97 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ReusableDocument.h"
+
+#include <algorithm>
+
+#include <rapidjson/memorystream.h>
+
+#include <JsonErrors.h>
+
+#include "RapidJsonHelpers.h"
+
+namespace JsonSchemaValidator {
+
+namespace {
+
+size_t const kInitialValuesSize = 64 * 1024;
+size_t const kInitialStackSize = 16 * 1024;
+size_t const kStackCapacity = 1024;
+// Buffers are not enlarged beyond these sizes, larger documents use additional chunks of
+// allocators, which are freed before next document.
+size_t const kMaxValuesSize = 16 * 1024 * 1024;
+size_t const kMaxStackSize = 4 * 1024 * 1024;
+
+} // namespace
+
+ReusableDocument::ReusableDocument()
+	: values_buffer_(kInitialValuesSize)
+	, stack_buffer_(kInitialStackSize)
+	, values_allocator_()
+	, stack_allocator_()
+	, document_() {
+}
+
+JsonValue const &ReusableDocument::Parse(char const *document) {
+	rapidjson::StringStream stream(document);
+	return Parse<0>(stream);
+}
+
+JsonValue const &ReusableDocument::Parse(char const *document, size_t length) {
+	rapidjson::MemoryStream stream(document, length);
+	return Parse<0>(stream);
+}
+
+JsonValue const &ReusableDocument::ParseInsitu(char *document, size_t length) {
+	InsituBufferStream stream(document, length);
+	return Parse<rapidjson::kParseInsituFlag>(stream);
+}
+
+template <unsigned ParseFlags, typename Stream>
+JsonValue const &ReusableDocument::Parse(Stream &stream) {
+	Reset();
+
+	document_->ParseStream<ParseFlags>(stream);
+	if (document_->HasParseError()) {
+		throw IncorrectJson(GetLastError(rapidjson::ParseResult(document_->GetParseError(),
+		                                                        document_->GetErrorOffset())));
+	}
+	return *document_;
+}
+
+void ReusableDocument::Reset() {
+	// Capacity of allocator exceeds size of its buffer only if additional chunks were allocated.
+	size_t values_size = std::min(document_ ? values_allocator_->Capacity() : 0, kMaxValuesSize);
+	size_t stack_size = std::min(document_ ? stack_allocator_->Capacity() : 0, kMaxStackSize);
+	if (document_ && values_size <= values_buffer_.size() && stack_size <= stack_buffer_.size()) {
+		document_->SetNull();
+		values_allocator_->Clear();
+		stack_allocator_->Clear();
+		return;
+	}
+
+	document_.reset();
+	stack_allocator_.reset();
+	values_allocator_.reset();
+
+	values_buffer_.resize(std::max(values_size, values_buffer_.size()));
+	stack_buffer_.resize(std::max(stack_size, stack_buffer_.size()));
+	values_allocator_.reset(new Allocator(values_buffer_.data(), values_buffer_.size()));
+	stack_allocator_.reset(new Allocator(stack_buffer_.data(), stack_buffer_.size()));
+	document_.reset(new Document(values_allocator_.get(), kStackCapacity,
+	                             stack_allocator_.get()));
+}
+
+} // namespace JsonSchemaValidator
@@ -0,0 +1,61 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <rapidjson/document.h>
+
+#include "Defs.h"
+#include "RapidJsonDefs.h"
+
+namespace JsonSchemaValidator {
+
+// Document for parsing of many json-documents one by one. Values and stack of parser are
+// allocated in buffers which are reset (not freed) before next document. If some document
+// doesn't fit to buffers, they are enlarged, so when buffers become large enough for usual
+// documents, parsing doesn't allocate memory. Buffers are enlarged only up to limit, so single
+// huge document doesn't keep its memory.
+class ReusableDocument {
+public:
+	ReusableDocument();
+
+	ReusableDocument(ReusableDocument const &) = delete;
+	ReusableDocument &operator=(ReusableDocument const &) = delete;
+
+	// Returned value is valid until next call of Parse.
+	JsonValue const &Parse(char const *document);
+	JsonValue const &Parse(char const *document, size_t length);
+	// Document is parsed in-situ, so its buffer is changed and must live while returned value
+	// is used.
+	JsonValue const &ParseInsitu(char *document, size_t length);
+
+private:
+	typedef rapidjson::MemoryPoolAllocator<> Allocator;
+	typedef rapidjson::GenericDocument<rapidjson::UTF8<>, Allocator, Allocator> Document;
+
+	template <unsigned ParseFlags, typename Stream>
+	JsonValue const &Parse(Stream &stream);
+	void Reset();
+
+	std::vector<char> values_buffer_;
+	std::vector<char> stack_buffer_;
+	std::unique_ptr<Allocator> values_allocator_;
+	std::unique_ptr<Allocator> stack_allocator_;
+	std::unique_ptr<Document> document_;
+}; // class ReusableDocument
+
+} // namespace JsonSchemaValidator
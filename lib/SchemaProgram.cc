@@ -0,0 +1,1228 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "SchemaProgram.h"
+
+#include <cstring>
+
+#include <JsonSchema.h>
+
+#include "ArrayElements.h"
+#include "BinarySchema.h"
+#include "JsonType.h"
+#include "Regex.h"
+#include "ValidationContext.h"
+#include "types/PrimitiveTypes.h"
+
+namespace JsonSchemaValidator {
+
+namespace {
+
+// Index of bit of kind of value in JsonValueKind.
+size_t GetKindIndex(JsonValue const &json) {
+	switch (GetValueKind(json)) {
+	case kNullKind:
+		return 0;
+	case kBooleanKind:
+		return 1;
+	case kObjectKind:
+		return 2;
+	case kArrayKind:
+		return 3;
+	case kStringKind:
+		return 4;
+	case kIntegerKind:
+		return 5;
+	default:
+		return 6;
+	}
+}
+
+// Error which has no parameters of restrictions of node.
+DocumentErrorPtr CreateCommonError(DocumentErrors error, char const *name) {
+	switch (error) {
+	case DocumentErrors::EnumValue:
+		return DocumentErrorPtr(new EnumValueError());
+	case DocumentErrors::AdditionalProperty:
+		return DocumentErrorPtr(new AdditionalPropertyError(name));
+	case DocumentErrors::DependenciesRestrictions:
+		return DocumentErrorPtr(new DependenciesRestrictionsError(name));
+	case DocumentErrors::RequiredProperty:
+		return DocumentErrorPtr(new RequiredPropertyError(name));
+	case DocumentErrors::UniqueItems:
+		return DocumentErrorPtr(new UniqueItemsError());
+	case DocumentErrors::AdditionalItems:
+		return DocumentErrorPtr(new AdditionalItemsError());
+	case DocumentErrors::DisallowType:
+		return DocumentErrorPtr(new DisallowTypeError());
+	case DocumentErrors::NeitherType:
+		return DocumentErrorPtr(new NeitherTypeError());
+	default:
+		return DocumentErrorPtr(new TypeError());
+	}
+}
+
+void CheckImage(bool condition) {
+	if (!condition) {
+		throw IncorrectSchema(SchemaErrors::IncorrectBinarySchema);
+	}
+}
+
+// Table is written as count of its items followed by items.
+template <typename Table>
+void WriteTable(Table const &table, std::string &image) {
+	uint64_t const count = table.size();
+	image.append(reinterpret_cast<char const *>(&count), sizeof(count));
+	image.append(reinterpret_cast<char const *>(table.data()),
+	             table.size() * sizeof(typename Table::value_type));
+}
+
+// Tables are copied from image, because image has no alignment of them.
+class TablesReader {
+public:
+	TablesReader(char const *data, size_t size)
+		: data_(data)
+		, size_(size) {
+	}
+
+	template <typename Table>
+	void Read(Table &table) {
+		uint64_t count = 0;
+		CheckImage(size_ >= sizeof(count));
+		memcpy(&count, data_, sizeof(count));
+		Skip(sizeof(count));
+		CheckImage(count <= size_ / sizeof(typename Table::value_type));
+		table.resize(count);
+		if (count > 0) {
+			memcpy(&table[0], data_, count * sizeof(typename Table::value_type));
+		}
+		Skip(count * sizeof(typename Table::value_type));
+	}
+
+	bool IsFinished() const {
+		return size_ == 0;
+	}
+
+private:
+	void Skip(size_t size) {
+		data_ += size;
+		size_ -= size;
+	}
+
+	char const *data_;
+	size_t size_;
+}; // class TablesReader
+
+enum NodeState {
+	kNotVisited,
+	kVisiting,
+	kVisited
+}; // enum NodeState
+
+} // namespace
+
+uint32_t const SchemaProgram::kNone;
+
+SchemaProgram::Builder::Builder(SchemaProgram &program)
+	: program_(program)
+	, nodes_() {
+}
+
+uint32_t SchemaProgram::Builder::AddNode(JsonType const &type) {
+	auto found = nodes_.find(&type);
+	if (found != nodes_.end()) {
+		return found->second;
+	}
+	uint32_t const index = static_cast<uint32_t>(program_.nodes_.size());
+	nodes_.insert({ &type, index });
+	program_.nodes_.push_back(Node());
+
+	Node node = Node();
+	node.ref_kind = kNoRef;
+	node.ref = kNone;
+	node.extends = kNone;
+	node.enum_values = kNone;
+	node.restrictions = kNone;
+	type.Lower(*this, node);
+	program_.nodes_[index] = node;
+	return index;
+}
+
+uint32_t SchemaProgram::Builder::AddNodes(std::vector<JsonTypePtr> const &types) {
+	std::vector<uint32_t> nodes;
+	for (auto const &type : types) {
+		nodes.push_back(AddNode(*type));
+	}
+	return AddList(nodes);
+}
+
+uint32_t SchemaProgram::Builder::AddList(std::vector<uint32_t> const &items) {
+	uint32_t const list = static_cast<uint32_t>(program_.lists_.size());
+	program_.lists_.push_back(static_cast<uint32_t>(items.size()));
+	program_.lists_.insert(program_.lists_.end(), items.begin(), items.end());
+	return list;
+}
+
+uint32_t SchemaProgram::Builder::AddString(char const *string) {
+	uint32_t const offset = static_cast<uint32_t>(program_.strings_.size());
+	program_.strings_.append(string);
+	program_.strings_.push_back('\0');
+	return offset;
+}
+
+uint32_t SchemaProgram::Builder::AddEnum(JsonValueSet const &values) {
+	program_.enums_.push_back(values);
+	return static_cast<uint32_t>(program_.enums_.size() - 1);
+}
+
+uint32_t SchemaProgram::Builder::AddExternalRef(ExternalRefPtr const &ref) {
+	program_.external_refs_.push_back(ref);
+	return static_cast<uint32_t>(program_.external_refs_.size() - 1);
+}
+
+uint32_t SchemaProgram::Builder::AddMask(NameSet::Mask const &mask) {
+	return AddWords(mask.data(), mask.size());
+}
+
+uint32_t SchemaProgram::Builder::AddNameTable(NameTable const &table) {
+	NameTableLayout layout = NameTableLayout();
+	layout.seed = table.GetSeed();
+	std::vector<uint32_t> names;
+	for (char const *name : table.GetNames()) {
+		names.push_back(AddString(name));
+	}
+	layout.names = AddList(names);
+	layout.displacements = AddWords(table.GetDisplacements().data(),
+	                                table.GetDisplacements().size());
+	std::vector<uint32_t> slots;
+	for (size_t slot : table.GetSlots()) {
+		slots.push_back(slot == NameTable::kNotFound ? kNone : static_cast<uint32_t>(slot));
+	}
+	layout.slots = AddList(slots);
+	program_.name_table_layouts_.push_back(layout);
+	return static_cast<uint32_t>(program_.name_table_layouts_.size() - 1);
+}
+
+uint32_t SchemaProgram::Builder::AddRegex(RegexPtr const &regex) {
+	program_.regex_patterns_.push_back(AddString(regex->Pattern()));
+	program_.regexes_.push_back(regex);
+	return static_cast<uint32_t>(program_.regexes_.size() - 1);
+}
+
+uint32_t SchemaProgram::Builder::AddRegexSet(RegexSetPtr const &regex_set) {
+	std::vector<uint32_t> patterns;
+	for (auto const &pattern : regex_set->Patterns()) {
+		patterns.push_back(AddString(pattern.c_str()));
+	}
+	program_.regex_set_patterns_.push_back(AddList(patterns));
+	program_.regex_sets_.push_back(regex_set);
+	return static_cast<uint32_t>(program_.regex_sets_.size() - 1);
+}
+
+uint32_t SchemaProgram::Builder::Add(StringRestrictions const &restrictions) {
+	program_.strings_restrictions_.push_back(restrictions);
+	return static_cast<uint32_t>(program_.strings_restrictions_.size() - 1);
+}
+
+uint32_t SchemaProgram::Builder::Add(NumberRestrictions<double> const &restrictions) {
+	program_.numbers_restrictions_.push_back(restrictions);
+	return static_cast<uint32_t>(program_.numbers_restrictions_.size() - 1);
+}
+
+uint32_t SchemaProgram::Builder::Add(NumberRestrictions<long long> const &restrictions) {
+	program_.integers_restrictions_.push_back(restrictions);
+	return static_cast<uint32_t>(program_.integers_restrictions_.size() - 1);
+}
+
+uint32_t SchemaProgram::Builder::Add(ObjectRestrictions const &restrictions) {
+	program_.objects_restrictions_.push_back(restrictions);
+	return static_cast<uint32_t>(program_.objects_restrictions_.size() - 1);
+}
+
+uint32_t SchemaProgram::Builder::Add(SimpleDependency const &dependency) {
+	program_.simple_dependencies_.push_back(dependency);
+	return static_cast<uint32_t>(program_.simple_dependencies_.size() - 1);
+}
+
+uint32_t SchemaProgram::Builder::Add(ArrayRestrictions const &restrictions) {
+	program_.arrays_restrictions_.push_back(restrictions);
+	return static_cast<uint32_t>(program_.arrays_restrictions_.size() - 1);
+}
+
+uint32_t SchemaProgram::Builder::Add(AnyRestrictions const &restrictions) {
+	program_.any_restrictions_.push_back(restrictions);
+	return static_cast<uint32_t>(program_.any_restrictions_.size() - 1);
+}
+
+uint32_t SchemaProgram::Builder::AddWords(uint64_t const *words, size_t count) {
+	uint32_t const offset = static_cast<uint32_t>(program_.words_.size());
+	program_.words_.push_back(count);
+	program_.words_.insert(program_.words_.end(), words, words + count);
+	return offset;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+SchemaProgram::NodeErrors::NodeErrors(SchemaProgram const &program, uint32_t node)
+	: program_(&program)
+	, node_(node) {
+}
+
+DocumentErrorPtr SchemaProgram::NodeErrors::CreateError(DocumentErrors error,
+                                                        char const *name) const {
+	return program_->CreateError(node_, error, name);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+SchemaProgram::SchemaProgram(JsonType const &root)
+	: nodes_()
+	, lists_()
+	, words_()
+	, strings_()
+	, strings_restrictions_()
+	, numbers_restrictions_()
+	, integers_restrictions_()
+	, objects_restrictions_()
+	, simple_dependencies_()
+	, arrays_restrictions_()
+	, any_restrictions_()
+	, name_table_layouts_()
+	, name_tables_()
+	, regex_patterns_()
+	, regexes_()
+	, regexes_flags_()
+	, regex_set_patterns_()
+	, regex_sets_()
+	, regex_sets_flags_()
+	, values_()
+	, enums_()
+	, external_refs_()
+	, errors_() {
+
+	Builder builder(*this);
+	builder.AddNode(root);
+	Finish();
+	// Cycle of references (e.g. {"$ref": "#"}) can't be detected until types are linked.
+	CheckRecursion(SchemaErrors::IncorrectRef);
+}
+
+SchemaProgram::SchemaProgram(BinarySchema const &image, JsonResolverPtr const &resolver)
+	: nodes_()
+	, lists_()
+	, words_()
+	, strings_()
+	, strings_restrictions_()
+	, numbers_restrictions_()
+	, integers_restrictions_()
+	, objects_restrictions_()
+	, simple_dependencies_()
+	, arrays_restrictions_()
+	, any_restrictions_()
+	, name_table_layouts_()
+	, name_tables_()
+	, regex_patterns_()
+	, regexes_()
+	, regexes_flags_()
+	, regex_set_patterns_()
+	, regex_sets_()
+	, regex_sets_flags_()
+	, values_()
+	, enums_()
+	, external_refs_()
+	, errors_() {
+
+	// Order of tables is order of Write.
+	TablesReader reader(image.GetProgram(), image.GetProgramSize());
+	reader.Read(nodes_);
+	reader.Read(lists_);
+	reader.Read(words_);
+	reader.Read(strings_);
+	reader.Read(strings_restrictions_);
+	reader.Read(numbers_restrictions_);
+	reader.Read(integers_restrictions_);
+	reader.Read(objects_restrictions_);
+	reader.Read(simple_dependencies_);
+	reader.Read(arrays_restrictions_);
+	reader.Read(any_restrictions_);
+	reader.Read(name_table_layouts_);
+	reader.Read(regex_patterns_);
+	reader.Read(regex_set_patterns_);
+	std::vector<uint32_t> enum_records;
+	reader.Read(enum_records);
+	std::string external_refs;
+	reader.Read(external_refs);
+	CheckImage(reader.IsFinished());
+
+	ReadEnums(image, enum_records);
+	for (size_t ref = 0; ref < external_refs.size(); ref = external_refs.find('\0', ref) + 1) {
+		CheckImage(external_refs.find('\0', ref) != std::string::npos);
+		external_refs_.push_back(std::make_shared<ExternalRef>(external_refs.c_str() + ref,
+		                                                       resolver));
+	}
+	CheckTables();
+	CheckRecursion(SchemaErrors::IncorrectBinarySchema);
+
+	regexes_.resize(regex_patterns_.size());
+	regex_sets_.resize(regex_set_patterns_.size());
+	Finish();
+	for (auto const &ref : external_refs_) {
+		ref->Link();
+	}
+}
+
+void SchemaProgram::Validate(JsonValue const &json, ValidationContext &context) const {
+	Validate(0, json, context);
+}
+
+size_t SchemaProgram::GetNodesCount() const {
+	return nodes_.size();
+}
+
+void SchemaProgram::Write(std::unordered_map<JsonValue const *, uint32_t> const &value_records,
+                          std::string &image) const {
+	std::vector<uint32_t> enum_records;
+	for (auto const &values : enums_) {
+		std::vector<JsonValue const *> const enum_values = values.GetValues();
+		enum_records.push_back(static_cast<uint32_t>(enum_values.size()));
+		for (JsonValue const *value : enum_values) {
+			enum_records.push_back(value_records.at(value));
+		}
+	}
+	std::string external_refs;
+	for (auto const &ref : external_refs_) {
+		external_refs.append(ref->GetRef());
+		external_refs.push_back('\0');
+	}
+
+	WriteTable(nodes_, image);
+	WriteTable(lists_, image);
+	WriteTable(words_, image);
+	WriteTable(strings_, image);
+	WriteTable(strings_restrictions_, image);
+	WriteTable(numbers_restrictions_, image);
+	WriteTable(integers_restrictions_, image);
+	WriteTable(objects_restrictions_, image);
+	WriteTable(simple_dependencies_, image);
+	WriteTable(arrays_restrictions_, image);
+	WriteTable(any_restrictions_, image);
+	WriteTable(name_table_layouts_, image);
+	WriteTable(regex_patterns_, image);
+	WriteTable(regex_set_patterns_, image);
+	WriteTable(enum_records, image);
+	WriteTable(external_refs, image);
+}
+
+void SchemaProgram::Validate(uint32_t index, JsonValue const &json,
+                             ValidationContext &context) const {
+	Node const &node = nodes_[index];
+	if (node.op == kUnionOp) {
+		if (!IsValidForAny(node.restrictions, json)) {
+			RaiseError(index, context, json, DocumentErrors::NeitherType);
+		}
+		return;
+	}
+	if (node.op == kAnyOp) {
+		AnyRestrictions const &any = any_restrictions_[node.restrictions];
+		if (any.disallow != kNone && IsValidForAny(any.disallow, json)) {
+			return RaiseError(index, context, json, DocumentErrors::DisallowType);
+		}
+		uint32_t const kind_type = any.kind_types[GetKindIndex(json)];
+		if (kind_type != kNone) {
+			return Validate(kind_type, json, context);
+		}
+	}
+
+	if (node.ref_kind != kNoRef) {
+		ValidateRef(node, json, context);
+		if (context.IsFailed()) return;
+	}
+	if (node.extends != kNone) {
+		uint32_t const *extends = GetList(node.extends);
+		for (uint32_t i = 1; i <= extends[0]; ++i) {
+			Validate(extends[i], json, context);
+			if (context.IsFailed()) return;
+		}
+	}
+	if (!(node.kinds & GetValueKind(json))) {
+		return RaiseError(index, context, json, DocumentErrors::Type);
+	}
+	if (node.enum_values != kNone && !enums_[node.enum_values].Contains(json)) {
+		return RaiseError(index, context, json, DocumentErrors::EnumValue);
+	}
+	if (node.restrictions == kNone) {
+		return;
+	}
+
+	switch (node.op) {
+	case kStringOp:
+		return ValidateString(index, strings_restrictions_[node.restrictions], json, context);
+	case kNumberOp:
+		return ValidateNumber(index, numbers_restrictions_[node.restrictions], json, context);
+	case kIntegerOp:
+		return ValidateNumber(index, integers_restrictions_[node.restrictions], json, context);
+	case kObjectOp:
+		return ValidateObject(index, objects_restrictions_[node.restrictions], json, context);
+	case kArrayOp:
+		return ValidateArray(index, arrays_restrictions_[node.restrictions], json, context);
+	case kAnyOp:
+		// Value of kind without own type, so enum has no elements of this kind.
+		if (any_restrictions_[node.restrictions].has_enum) {
+			RaiseError(index, context, json, DocumentErrors::EnumValue);
+		}
+		return;
+	case kCustomOp:
+		return Validate(node.restrictions, json, context);
+	default:
+		return;
+	}
+}
+
+void SchemaProgram::ValidateRef(Node const &node, JsonValue const &json,
+                                ValidationContext &context) const {
+	if (node.ref_kind == kLocalRef) {
+		return Validate(node.ref, json, context);
+	}
+	external_refs_[node.ref]->Validate(json, context);
+}
+
+void SchemaProgram::ValidateString(uint32_t index, StringRestrictions const &string,
+                                   JsonValue const &json, ValidationContext &context) const {
+	if (json.GetStringLength() < string.min_length) {
+		return RaiseError(index, context, json, DocumentErrors::MinimalLength);
+	}
+	if (json.GetStringLength() > string.max_length) {
+		return RaiseError(index, context, json, DocumentErrors::MaximalLength);
+	}
+
+	if (string.pattern != kNone &&
+	    !GetRegex(string.pattern).IsCorrespond(GetValue<char const *>(json))) {
+		return RaiseError(index, context, json, DocumentErrors::Pattern);
+	}
+}
+
+template <typename Type>
+void SchemaProgram::ValidateNumber(uint32_t index, NumberRestrictions<Type> const &number,
+                                   JsonValue const &json, ValidationContext &context) const {
+	typedef JsonBaseNumber<Type> Checks;
+	Type const value = GetValue<Type>(json);
+	if ((value < number.minimum) ||
+	    (number.exclusive_minimum && Checks::IsEqual(value, number.minimum))) {
+		return RaiseError(index, context, json, DocumentErrors::MinimumValue);
+	}
+	if ((number.maximum < value) ||
+	    (number.exclusive_maximum && Checks::IsEqual(number.maximum, value))) {
+		return RaiseError(index, context, json, DocumentErrors::MaximumValue);
+	}
+
+	if (number.has_divisible_by && !Checks::CheckDivisibility(value, number.divisible_by)) {
+		return RaiseError(index, context, json, DocumentErrors::DivisibleValue);
+	}
+}
+
+void SchemaProgram::ValidateObject(uint32_t index, ObjectRestrictions const &object,
+                                   JsonValue const &json, ValidationContext &context) const {
+	NameTable const &names = name_tables_[object.names];
+	uint32_t const *properties = GetList(object.properties);
+	uint32_t const *pattern_properties =
+		object.patterns != kNone ? GetList(object.pattern_properties) : nullptr;
+	uint32_t const *dependency_indexes =
+		object.dependency_indexes != kNone ? GetList(object.dependency_indexes) : nullptr;
+
+	NameSet present_names(names.Size());
+	if (dependency_indexes) {
+		// Dependencies are checked in order of members, so all names are found before.
+		for (auto const &member : GetMembers(json)) {
+			size_t name_index = names.Find(GetValue<char const *>(member.name),
+			                               member.name.GetStringLength());
+			if (name_index != NameTable::kNotFound) {
+				present_names.Insert(name_index);
+			}
+		}
+	}
+	NameSet pattern_matches(pattern_properties ? pattern_properties[0] : 0);
+	for (auto const &member : GetMembers(json)) {
+		bool described_property = false;
+		char const *name = GetValue<char const *>(member.name);
+		MemberPathHolder path_holder(name, context);
+		size_t name_index = names.Find(name, member.name.GetStringLength());
+		if (name_index != NameTable::kNotFound) {
+			present_names.Insert(name_index);
+		}
+		if (name_index < properties[0]) {
+			Validate(properties[name_index + 1], member.value, context);
+			if (context.IsFailed() && !context.Recover()) return;
+			described_property = true;
+		}
+		if (pattern_properties) {
+			GetRegexSet(object.patterns).Match(name, member.name.GetStringLength(),
+			                                   pattern_matches);
+			for (uint32_t match = 0; match < pattern_properties[0]; ++match) {
+				if (!pattern_matches.Contains(match)) {
+					continue;
+				}
+				Validate(pattern_properties[match + 1], member.value, context);
+				if (context.IsFailed() && !context.Recover()) return;
+				described_property = true;
+			}
+		}
+
+		if (!described_property) {
+			if (object.additional == kForbidAdditional) {
+				path_holder.Reset();
+				RaiseError(index, context, json, DocumentErrors::AdditionalProperty, name);
+				if (!context.Recover()) return;
+			}
+			else if (object.additional == kValidateAdditional) {
+				Validate(object.additional_properties, member.value, context);
+				if (context.IsFailed() && !context.Recover()) return;
+			}
+		}
+
+		if (dependency_indexes && name_index != NameTable::kNotFound &&
+		    dependency_indexes[name_index + 1] != kNone) {
+			SimpleDependency const &dependency =
+				simple_dependencies_[object.simple_dependencies + dependency_indexes[name_index + 1]];
+			uint64_t const *mask = &words_[dependency.dependencies];
+			if (present_names.FindMissing(mask + 1, mask[0]) != NameTable::kNotFound) {
+				RaiseError(index, context, json, DocumentErrors::DependenciesRestrictions, name);
+				if (!context.Recover()) return;
+			}
+		}
+		if (object.schema_dependencies != kNone) {
+			size_t dependency = name_tables_[object.schema_dependency_names].Find(
+				name, member.name.GetStringLength());
+			if (dependency != NameTable::kNotFound) {
+				Validate(GetList(object.schema_dependencies)[dependency + 1], json, context);
+				if (context.IsFailed() && !context.Recover()) return;
+			}
+		}
+	}
+
+	uint64_t const *required = &words_[object.required];
+	size_t missing_property = present_names.FindMissing(required + 1, required[0]);
+	if (missing_property != NameTable::kNotFound) {
+		uint32_t const *names_list = GetList(name_table_layouts_[object.names].names);
+		return RaiseError(index, context, json, DocumentErrors::RequiredProperty,
+		                  GetString(names_list[missing_property + 1]));
+	}
+}
+
+void SchemaProgram::ValidateArray(uint32_t index, ArrayRestrictions const &array,
+                                  JsonValue const &json, ValidationContext &context) const {
+	if (json.Size() < array.min_items) {
+		return RaiseError(index, context, json, DocumentErrors::MinimalItemsCount);
+	}
+	if (json.Size() > array.max_items) {
+		return RaiseError(index, context, json, DocumentErrors::MaximalItemsCount);
+	}
+
+	if (array.unique_items && !HasUniqueElements(json)) {
+		return RaiseError(index, context, json, DocumentErrors::UniqueItems);
+	}
+
+	auto validate_elements = [this, &json, &context](rapidjson::SizeType begin, uint32_t type) {
+		ValidateElements(json, begin, [this, type](JsonValue const &element,
+		                                           ValidationContext &element_context) {
+			Validate(type, element, element_context);
+		}, context);
+	};
+	if (array.items != kNone) {
+		validate_elements(0, array.items);
+	}
+	else if (array.items_list != kNone) {
+		uint32_t const *items = GetList(array.items_list);
+		rapidjson::SizeType i = 0;
+		for (; i < json.Size() && i < items[0]; ++i) {
+			ElementPathHolder path_holder(i, context);
+			Validate(items[i + 1], json[i], context);
+			if (context.IsFailed() && !context.Recover()) return;
+		}
+		if (i < json.Size()) {
+			if (array.additional == kForbidAdditional) {
+				return RaiseError(index, context, json, DocumentErrors::AdditionalItems);
+			}
+			if (array.additional == kValidateAdditional) {
+				validate_elements(i, array.additional_items);
+			}
+		}
+	}
+}
+
+bool SchemaProgram::GetStreamNodes(uint32_t index, rapidjson::Type type,
+                                   std::vector<uint32_t> &nodes) const {
+	Node const &node = nodes_[index];
+	bool const is_object = (type == rapidjson::kObjectType);
+	if (node.op == kAnyOp) {
+		AnyRestrictions const &any = any_restrictions_[node.restrictions];
+		if (any.disallow != kNone) {
+			return false;
+		}
+		// Indexes of kinds of objects and arrays in JsonValueKind.
+		uint32_t const kind_type = any.kind_types[is_object ? 2 : 3];
+		if (kind_type != kNone) {
+			return GetStreamNodes(kind_type, type, nodes);
+		}
+	}
+	// Container of other kind is collected, so its error is raised by Validate. Enum and external
+	// schema check whole value.
+	if (node.ref_kind == kExternalRef || node.enum_values != kNone ||
+	    !(node.kinds & (is_object ? kObjectKind : kArrayKind))) {
+		return false;
+	}
+	// Referenced and extended nodes check the same container, they have no cycles (see
+	// CheckRecursion), so their expansion is finite.
+	if (node.ref_kind == kLocalRef && !GetStreamNodes(node.ref, type, nodes)) {
+		return false;
+	}
+	if (node.extends != kNone) {
+		uint32_t const *extends = GetList(node.extends);
+		for (uint32_t i = 1; i <= extends[0]; ++i) {
+			if (!GetStreamNodes(extends[i], type, nodes)) {
+				return false;
+			}
+		}
+	}
+
+	switch (node.op) {
+	case kObjectOp:
+		if (node.restrictions != kNone &&
+		    objects_restrictions_[node.restrictions].schema_dependencies != kNone) {
+			return false;
+		}
+		break;
+	case kArrayOp:
+		if (node.restrictions != kNone && arrays_restrictions_[node.restrictions].unique_items) {
+			return false;
+		}
+		break;
+	case kAnyOp:
+		// Container without own type has no restrictions for its elements.
+		return !any_restrictions_[node.restrictions].has_enum;
+	case kCustomOp:
+		return GetStreamNodes(node.restrictions, type, nodes);
+	default:
+		return false;
+	}
+	nodes.push_back(index);
+	return true;
+}
+
+void SchemaProgram::StartObject(uint32_t index, NameSet &present_names) const {
+	Node const &node = nodes_[index];
+	if (node.op != kObjectOp || node.restrictions == kNone) {
+		return present_names.Reset(0);
+	}
+	present_names.Reset(name_tables_[objects_restrictions_[node.restrictions].names].Size());
+}
+
+void SchemaProgram::GetMemberNodes(uint32_t index, char const *name, JsonSizeType length,
+                                   std::vector<uint32_t> &nodes, NameSet &present_names,
+                                   ValidationContext &context) const {
+	Node const &node = nodes_[index];
+	if (node.op != kObjectOp || node.restrictions == kNone) {
+		return;
+	}
+	ObjectRestrictions const &object = objects_restrictions_[node.restrictions];
+	uint32_t const *properties = GetList(object.properties);
+
+	bool described_property = false;
+	size_t name_index = name_tables_[object.names].Find(name, length);
+	if (name_index != NameTable::kNotFound) {
+		present_names.Insert(name_index);
+	}
+	if (name_index < properties[0]) {
+		nodes.push_back(properties[name_index + 1]);
+		described_property = true;
+	}
+	if (object.patterns != kNone) {
+		uint32_t const *pattern_properties = GetList(object.pattern_properties);
+		NameSet pattern_matches(pattern_properties[0]);
+		GetRegexSet(object.patterns).Match(name, length, pattern_matches);
+		for (uint32_t match = 0; match < pattern_properties[0]; ++match) {
+			if (pattern_matches.Contains(match)) {
+				nodes.push_back(pattern_properties[match + 1]);
+				described_property = true;
+			}
+		}
+	}
+
+	if (!described_property) {
+		if (object.additional == kForbidAdditional) {
+			return RaiseError(index, context, DocumentErrors::AdditionalProperty, name);
+		}
+		if (object.additional == kValidateAdditional) {
+			nodes.push_back(object.additional_properties);
+		}
+	}
+}
+
+void SchemaProgram::GetElementNodes(uint32_t index, JsonSizeType element,
+                                    std::vector<uint32_t> &nodes,
+                                    ValidationContext &context) const {
+	Node const &node = nodes_[index];
+	if (node.op != kArrayOp || node.restrictions == kNone) {
+		return;
+	}
+	ArrayRestrictions const &array = arrays_restrictions_[node.restrictions];
+	if (array.items != kNone) {
+		nodes.push_back(array.items);
+	}
+	else if (array.items_list != kNone) {
+		uint32_t const *items = GetList(array.items_list);
+		if (element < items[0]) {
+			nodes.push_back(items[element + 1]);
+		}
+		else if (array.additional == kForbidAdditional) {
+			return RaiseError(index, context, DocumentErrors::AdditionalItems);
+		}
+		else if (array.additional == kValidateAdditional) {
+			nodes.push_back(array.additional_items);
+		}
+	}
+}
+
+void SchemaProgram::FinishObject(uint32_t index, NameSet const &present_names,
+                                 ValidationContext &context) const {
+	Node const &node = nodes_[index];
+	if (node.op != kObjectOp || node.restrictions == kNone) {
+		return;
+	}
+	ObjectRestrictions const &object = objects_restrictions_[node.restrictions];
+	// Members are not available after streaming, so dependencies are checked in their order.
+	uint32_t const dependencies_count =
+		object.dependency_indexes != kNone ? object.simple_dependencies_count : 0;
+	for (uint32_t i = 0; i < dependencies_count; ++i) {
+		SimpleDependency const &dependency = simple_dependencies_[object.simple_dependencies + i];
+		uint64_t const *mask = &words_[dependency.dependencies];
+		if (present_names.Contains(dependency.index) &&
+		    present_names.FindMissing(mask + 1, mask[0]) != NameTable::kNotFound) {
+			char const *name = GetString(dependency.name);
+			MemberPathHolder path_holder(name, context);
+			return RaiseError(index, context, DocumentErrors::DependenciesRestrictions, name);
+		}
+	}
+
+	uint64_t const *required = &words_[object.required];
+	size_t missing_property = present_names.FindMissing(required + 1, required[0]);
+	if (missing_property != NameTable::kNotFound) {
+		uint32_t const *names_list = GetList(name_table_layouts_[object.names].names);
+		return RaiseError(index, context, DocumentErrors::RequiredProperty,
+		                  GetString(names_list[missing_property + 1]));
+	}
+}
+
+void SchemaProgram::FinishArray(uint32_t index, JsonSizeType size,
+                                ValidationContext &context) const {
+	Node const &node = nodes_[index];
+	if (node.op != kArrayOp || node.restrictions == kNone) {
+		return;
+	}
+	ArrayRestrictions const &array = arrays_restrictions_[node.restrictions];
+	if (size < array.min_items) {
+		return RaiseError(index, context, DocumentErrors::MinimalItemsCount);
+	}
+	if (size > array.max_items) {
+		return RaiseError(index, context, DocumentErrors::MaximalItemsCount);
+	}
+}
+
+bool SchemaProgram::IsValidForAny(uint32_t list, JsonValue const &json) const {
+	uint32_t const *types = GetList(list);
+	for (uint32_t i = 1; i <= types[0]; ++i) {
+		ValidationResult type_result;
+		ValidationContext type_context(type_result, false);
+		Validate(types[i], json, type_context);
+		if (type_result) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void SchemaProgram::RaiseError(uint32_t index, ValidationContext &context, JsonValue const &json,
+                               DocumentErrors error, char const *name) const {
+	context.RaiseError(error, &errors_[index], &json, name);
+}
+
+void SchemaProgram::RaiseError(uint32_t index, ValidationContext &context, DocumentErrors error,
+                               char const *name) const {
+	context.RaiseError(error, &errors_[index], nullptr, name);
+}
+
+Regex const &SchemaProgram::GetRegex(uint32_t regex) const {
+	std::call_once(regexes_flags_[regex], [this, regex] {
+		if (!regexes_[regex]) {
+			regexes_[regex] = Regex::Create(GetString(regex_patterns_[regex]));
+		}
+	});
+	return *regexes_[regex];
+}
+
+RegexSet const &SchemaProgram::GetRegexSet(uint32_t regex_set) const {
+	std::call_once(regex_sets_flags_[regex_set], [this, regex_set] {
+		if (!regex_sets_[regex_set]) {
+			uint32_t const *patterns_list = GetList(regex_set_patterns_[regex_set]);
+			std::vector<char const *> patterns;
+			for (uint32_t i = 1; i <= patterns_list[0]; ++i) {
+				patterns.push_back(GetString(patterns_list[i]));
+			}
+			regex_sets_[regex_set] = RegexSet::Create(patterns);
+		}
+	});
+	return *regex_sets_[regex_set];
+}
+
+DocumentErrorPtr SchemaProgram::CreateError(uint32_t index, DocumentErrors error,
+                                            char const *name) const {
+	Node const &node = nodes_[index];
+	switch (error) {
+	case DocumentErrors::MinimalLength:
+		return DocumentErrorPtr(new MinimalLengthError(
+			strings_restrictions_[node.restrictions].min_length));
+	case DocumentErrors::MaximalLength:
+		return DocumentErrorPtr(new MaximalLengthError(
+			strings_restrictions_[node.restrictions].max_length));
+	case DocumentErrors::Pattern:
+		return DocumentErrorPtr(new PatternError(GetString(
+			regex_patterns_[strings_restrictions_[node.restrictions].pattern])));
+	case DocumentErrors::MinimumValue:
+		if (node.op == kIntegerOp) {
+			auto const &integer = integers_restrictions_[node.restrictions];
+			return DocumentErrorPtr(new MinimumValueError<long long>(
+				integer.minimum, integer.exclusive_minimum != 0));
+		}
+		return DocumentErrorPtr(new MinimumValueError<double>(
+			numbers_restrictions_[node.restrictions].minimum,
+			numbers_restrictions_[node.restrictions].exclusive_minimum != 0));
+	case DocumentErrors::MaximumValue:
+		if (node.op == kIntegerOp) {
+			auto const &integer = integers_restrictions_[node.restrictions];
+			return DocumentErrorPtr(new MaximumValueError<long long>(
+				integer.maximum, integer.exclusive_maximum != 0));
+		}
+		return DocumentErrorPtr(new MaximumValueError<double>(
+			numbers_restrictions_[node.restrictions].maximum,
+			numbers_restrictions_[node.restrictions].exclusive_maximum != 0));
+	case DocumentErrors::DivisibleValue:
+		return DocumentErrorPtr(new DivisibleValueError(node.op == kIntegerOp
+			? integers_restrictions_[node.restrictions].divisible_by
+			: numbers_restrictions_[node.restrictions].divisible_by));
+	case DocumentErrors::MinimalItemsCount:
+		return DocumentErrorPtr(new MinimalItemsCountError(
+			arrays_restrictions_[node.restrictions].min_items));
+	case DocumentErrors::MaximalItemsCount:
+		return DocumentErrorPtr(new MaximalItemsCountError(
+			arrays_restrictions_[node.restrictions].max_items));
+	default:
+		return CreateCommonError(error, name);
+	}
+}
+
+uint32_t const *SchemaProgram::GetList(uint32_t list) const {
+	return &lists_[list];
+}
+
+char const *SchemaProgram::GetString(uint32_t string) const {
+	return strings_.data() + string;
+}
+
+void SchemaProgram::Finish() {
+	// Names of tables refer to strings of program, so tables are restored after lowering.
+	for (auto const &layout : name_table_layouts_) {
+		uint32_t const *names_list = GetList(layout.names);
+		std::vector<char const *> names;
+		for (uint32_t i = 1; i <= names_list[0]; ++i) {
+			names.push_back(GetString(names_list[i]));
+		}
+		uint64_t const *displacements = &words_[layout.displacements];
+		uint32_t const *slots_list = GetList(layout.slots);
+		std::vector<size_t> slots;
+		for (uint32_t i = 1; i <= slots_list[0]; ++i) {
+			slots.push_back(slots_list[i] == kNone ? NameTable::kNotFound : slots_list[i]);
+		}
+		name_tables_.emplace_back();
+		CheckImage(name_tables_.back().Restore(
+			names, layout.seed,
+			std::vector<uint64_t>(displacements + 1, displacements + 1 + displacements[0]), slots));
+	}
+	regexes_flags_ = std::vector<std::once_flag>(regexes_.size());
+	regex_sets_flags_ = std::vector<std::once_flag>(regex_sets_.size());
+	for (uint32_t node = 0; node < nodes_.size(); ++node) {
+		errors_.emplace_back(*this, node);
+	}
+}
+
+void SchemaProgram::ReadEnums(BinarySchema const &image,
+                              std::vector<uint32_t> const &enum_records) {
+	// Values are not moved by insertion into reserved array, so sets refer to them.
+	values_.SetArray();
+	values_.Reserve(static_cast<rapidjson::SizeType>(enum_records.size()),
+	                values_.GetAllocator());
+	for (size_t i = 0; i < enum_records.size(); i += enum_records[i] + 1) {
+		CheckImage(enum_records[i] < enum_records.size() - i);
+		enums_.emplace_back();
+		for (size_t record = i + 1; record <= i + enum_records[i]; ++record) {
+			JsonValue value;
+			image.Read(enum_records[record], value, values_);
+			values_.PushBack(value, values_.GetAllocator());
+			enums_.back().Insert(values_[values_.Size() - 1]);
+		}
+	}
+}
+
+void SchemaProgram::CheckTables() const {
+	CheckImage(!nodes_.empty() && (strings_.empty() || strings_.back() == '\0'));
+	// Other checks of name tables are done by their restoring.
+	for (auto const &layout : name_table_layouts_) {
+		CheckImage(IsStringsList(layout.names) && IsWords(layout.displacements) &&
+		           IsList(layout.slots));
+	}
+	for (uint32_t pattern : regex_patterns_) {
+		CheckImage(IsString(pattern));
+	}
+	for (uint32_t patterns : regex_set_patterns_) {
+		CheckImage(IsStringsList(patterns));
+	}
+	for (auto const &node : nodes_) {
+		CheckNode(node);
+	}
+	for (auto const &string : strings_restrictions_) {
+		CheckImage(string.pattern == kNone || string.pattern < regex_patterns_.size());
+	}
+	for (auto const &object : objects_restrictions_) {
+		CheckObject(object);
+	}
+	for (auto const &array : arrays_restrictions_) {
+		CheckArray(array);
+	}
+	for (auto const &any : any_restrictions_) {
+		CheckAny(any);
+	}
+}
+
+void SchemaProgram::CheckNode(Node const &node) const {
+	CheckImage(node.op < kOpsCount && node.ref_kind < kRefKindsCount);
+	CheckImage(node.ref_kind != kLocalRef || IsNode(node.ref));
+	CheckImage(node.ref_kind != kExternalRef || node.ref < external_refs_.size());
+	CheckImage(node.extends == kNone || IsNodesList(node.extends));
+	CheckImage(node.enum_values == kNone || node.enum_values < enums_.size());
+
+	bool const has_restrictions = node.restrictions != kNone;
+	switch (node.op) {
+	case kStringOp:
+		return CheckImage(!has_restrictions || node.restrictions < strings_restrictions_.size());
+	case kNumberOp:
+		return CheckImage(!has_restrictions || node.restrictions < numbers_restrictions_.size());
+	case kIntegerOp:
+		return CheckImage(!has_restrictions || node.restrictions < integers_restrictions_.size());
+	case kObjectOp:
+		return CheckImage(!has_restrictions || node.restrictions < objects_restrictions_.size());
+	case kArrayOp:
+		return CheckImage(!has_restrictions || node.restrictions < arrays_restrictions_.size());
+	case kAnyOp:
+		return CheckImage(node.restrictions < any_restrictions_.size());
+	case kUnionOp:
+		return CheckImage(IsNodesList(node.restrictions));
+	case kCustomOp:
+		return CheckImage(IsNode(node.restrictions));
+	default:
+		return;
+	}
+}
+
+void SchemaProgram::CheckObject(ObjectRestrictions const &object) const {
+	CheckImage(object.names < name_table_layouts_.size());
+	size_t const names_count = lists_[name_table_layouts_[object.names].names];
+	CheckImage(IsNodesList(object.properties) && lists_[object.properties] <= names_count);
+	CheckImage(IsMask(object.required, names_count));
+
+	if (object.patterns != kNone) {
+		CheckImage(object.patterns < regex_set_patterns_.size() &&
+		           IsNodesList(object.pattern_properties) &&
+		           lists_[object.pattern_properties] ==
+		           lists_[regex_set_patterns_[object.patterns]]);
+	}
+	CheckImage(object.additional < kAdditionalCount);
+	CheckImage(object.additional != kValidateAdditional || IsNode(object.additional_properties));
+
+	if (object.dependency_indexes != kNone) {
+		CheckImage(object.simple_dependencies < simple_dependencies_.size() &&
+		           object.simple_dependencies_count <=
+		           simple_dependencies_.size() - object.simple_dependencies);
+		CheckImage(IsList(object.dependency_indexes) &&
+		           lists_[object.dependency_indexes] == names_count);
+		uint32_t const *dependency_indexes = GetList(object.dependency_indexes);
+		for (uint32_t i = 1; i <= dependency_indexes[0]; ++i) {
+			CheckImage(dependency_indexes[i] == kNone ||
+			           dependency_indexes[i] < object.simple_dependencies_count);
+		}
+		for (uint32_t i = 0; i < object.simple_dependencies_count; ++i) {
+			SimpleDependency const &dependency =
+				simple_dependencies_[object.simple_dependencies + i];
+			CheckImage(IsString(dependency.name) && dependency.index < names_count &&
+			           IsMask(dependency.dependencies, names_count));
+		}
+	}
+	if (object.schema_dependencies != kNone) {
+		CheckImage(object.schema_dependency_names < name_table_layouts_.size() &&
+		           IsNodesList(object.schema_dependencies) &&
+		           lists_[object.schema_dependencies] ==
+		           lists_[name_table_layouts_[object.schema_dependency_names].names]);
+	}
+}
+
+void SchemaProgram::CheckArray(ArrayRestrictions const &array) const {
+	CheckImage(array.items == kNone || IsNode(array.items));
+	CheckImage(array.items_list == kNone || IsNodesList(array.items_list));
+	CheckImage(array.additional < kAdditionalCount);
+	CheckImage(array.additional != kValidateAdditional || IsNode(array.additional_items));
+}
+
+void SchemaProgram::CheckAny(AnyRestrictions const &any) const {
+	CheckImage(any.disallow == kNone || IsNodesList(any.disallow));
+	for (uint32_t kind_type : any.kind_types) {
+		CheckImage(kind_type == kNone || IsNode(kind_type));
+	}
+}
+
+void SchemaProgram::CheckRecursion(SchemaErrors error) const {
+	// Validation of value by node never returns, if it leads to validation of the same value by
+	// the same node. Nodes are checked for such cycles by depth-first search.
+	std::vector<unsigned char> states(nodes_.size(), kNotVisited);
+	std::vector<std::pair<uint32_t, std::vector<uint32_t>>> path;
+	for (uint32_t root = 0; root < nodes_.size(); ++root) {
+		if (states[root] != kNotVisited) {
+			continue;
+		}
+		states[root] = kVisiting;
+		path.emplace_back(root, std::vector<uint32_t>());
+		GetSameValueNodes(root, path.back().second);
+		while (!path.empty()) {
+			std::vector<uint32_t> &next_nodes = path.back().second;
+			if (next_nodes.empty()) {
+				states[path.back().first] = kVisited;
+				path.pop_back();
+				continue;
+			}
+			uint32_t const node = next_nodes.back();
+			next_nodes.pop_back();
+			if (states[node] == kVisiting) {
+				throw IncorrectSchema(error);
+			}
+			if (states[node] == kNotVisited) {
+				states[node] = kVisiting;
+				path.emplace_back(node, std::vector<uint32_t>());
+				GetSameValueNodes(node, path.back().second);
+			}
+		}
+	}
+}
+
+void SchemaProgram::GetSameValueNodes(uint32_t index, std::vector<uint32_t> &nodes) const {
+	auto add_list = [this, &nodes](uint32_t list) {
+		if (list != kNone) {
+			uint32_t const *items = GetList(list);
+			nodes.insert(nodes.end(), items + 1, items + 1 + items[0]);
+		}
+	};
+	Node const &node = nodes_[index];
+	if (node.ref_kind == kLocalRef) {
+		nodes.push_back(node.ref);
+	}
+	add_list(node.extends);
+	if (node.restrictions == kNone) {
+		return;
+	}
+	switch (node.op) {
+	case kObjectOp:
+		add_list(objects_restrictions_[node.restrictions].schema_dependencies);
+		break;
+	case kAnyOp: {
+		AnyRestrictions const &any = any_restrictions_[node.restrictions];
+		add_list(any.disallow);
+		for (uint32_t kind_type : any.kind_types) {
+			if (kind_type != kNone) {
+				nodes.push_back(kind_type);
+			}
+		}
+		break;
+	}
+	case kUnionOp:
+		add_list(node.restrictions);
+		break;
+	case kCustomOp:
+		nodes.push_back(node.restrictions);
+		break;
+	default:
+		break;
+	}
+}
+
+bool SchemaProgram::IsNode(uint32_t node) const {
+	return node < nodes_.size();
+}
+
+bool SchemaProgram::IsList(uint32_t list) const {
+	return list < lists_.size() && lists_[list] < lists_.size() - list;
+}
+
+bool SchemaProgram::IsNodesList(uint32_t list) const {
+	if (!IsList(list)) {
+		return false;
+	}
+	uint32_t const *items = GetList(list);
+	for (uint32_t i = 1; i <= items[0]; ++i) {
+		if (!IsNode(items[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool SchemaProgram::IsStringsList(uint32_t list) const {
+	if (!IsList(list)) {
+		return false;
+	}
+	uint32_t const *items = GetList(list);
+	for (uint32_t i = 1; i <= items[0]; ++i) {
+		if (!IsString(items[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool SchemaProgram::IsWords(uint32_t words) const {
+	return words < words_.size() && words_[words] < words_.size() - words;
+}
+
+bool SchemaProgram::IsMask(uint32_t mask, size_t names_count) const {
+	// Set of names has word for every 64 names, missing name is index of bit.
+	if (!IsWords(mask) || words_[mask] > (names_count + 63) / 64) {
+		return false;
+	}
+	for (uint64_t word = 0; word < words_[mask]; ++word) {
+		for (size_t bit = 0; bit < 64; ++bit) {
+			if ((words_[mask + 1 + word] & (uint64_t(1) << bit)) && word * 64 + bit >= names_count) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool SchemaProgram::IsString(uint32_t string) const {
+	return string < strings_.size();
+}
+
+} // namespace JsonSchemaValidator
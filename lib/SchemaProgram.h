@@ -0,0 +1,339 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include <JsonErrors.h>
+
+#include "Defs.h"
+#include "ExternalRef.h"
+#include "NameTable.h"
+#include "RapidJsonHelpers.h"
+
+namespace JsonSchemaValidator {
+
+class BinarySchema;
+
+// Schema compiled to flat program. Every type of linked tree of types is lowered to node of one
+// array, restrictions of node are stored in table of its operation and nested or referenced types
+// are referred by indexes of their nodes. So validation is one non-virtual function dispatching on
+// operation of node, which doesn't follow shared pointers. Nodes and tables contain no pointers.
+// Program is the only form of schema used for validation of DOM and streamed documents, tree of
+// types is freed after lowering. Program is written to binary image of schema and read from it
+// without compilation of types.
+class SchemaProgram {
+public:
+	static uint32_t const kNone = static_cast<uint32_t>(-1);
+
+	// Operation of node determines table of its restrictions.
+	enum Op {
+		kStringOp,
+		kNumberOp,
+		kIntegerOp,
+		kBooleanOp,
+		kNullOp,
+		kObjectOp,
+		kArrayOp,
+		// Type of schema without "type" or with type "any", values of kinds restricted by schema
+		// are checked by nodes of these kinds.
+		kAnyOp,
+		// Restrictions are list of nodes, value must be valid for one of them.
+		kUnionOp,
+		// Restrictions are index of node of type given by object in "type".
+		kCustomOp,
+		kOpsCount
+	}; // enum Op
+
+	enum RefKind {
+		kNoRef,
+		// Ref is index of node of subschema of the same document.
+		kLocalRef,
+		// Ref is index of reference resolved by resolver.
+		kExternalRef,
+		kRefKindsCount
+	}; // enum RefKind
+
+	// Restrictions of additional properties or items.
+	enum Additional {
+		kAllowAdditional,
+		kForbidAdditional,
+		kValidateAdditional,
+		kAdditionalCount
+	}; // enum Additional
+
+	struct Node {
+		uint8_t op;
+		// Mask of JsonValueKind.
+		uint8_t kinds;
+		uint8_t ref_kind;
+		uint8_t padding;
+		uint32_t ref;
+		// List of nodes of extended types or kNone.
+		uint32_t extends;
+		// Set of elements of enum or kNone.
+		uint32_t enum_values;
+		// Index in table of operation or kNone, if type has no restrictions of its operation.
+		uint32_t restrictions;
+	}; // struct Node
+
+	struct StringRestrictions {
+		uint64_t min_length;
+		uint64_t max_length;
+		// Regular expression or kNone.
+		uint32_t pattern;
+		uint32_t padding;
+	}; // struct StringRestrictions
+
+	template <typename Type>
+	struct NumberRestrictions {
+		Type minimum;
+		Type maximum;
+		double divisible_by;
+		uint8_t exclusive_minimum;
+		uint8_t exclusive_maximum;
+		uint8_t has_divisible_by;
+		uint8_t padding[5];
+	}; // struct NumberRestrictions
+
+	struct ObjectRestrictions {
+		// Table of names of properties followed by other names of simple dependencies, so index
+		// of property name is index of property.
+		uint32_t names;
+		// List of nodes of properties.
+		uint32_t properties;
+		// Mask of required properties.
+		uint32_t required;
+		// Set of patterns of pattern properties and list of their nodes or kNone.
+		uint32_t patterns;
+		uint32_t pattern_properties;
+		uint32_t additional;
+		uint32_t additional_properties;
+		// Range of simple dependencies and list of their indexes by indexes of names or kNone.
+		uint32_t simple_dependencies;
+		uint32_t simple_dependencies_count;
+		uint32_t dependency_indexes;
+		// Table of names of schema dependencies and list of their nodes or kNone.
+		uint32_t schema_dependency_names;
+		uint32_t schema_dependencies;
+	}; // struct ObjectRestrictions
+
+	struct SimpleDependency {
+		// Name is string, index is index of name in table of object.
+		uint32_t name;
+		uint32_t index;
+		// Mask of names, which must be present with name.
+		uint32_t dependencies;
+	}; // struct SimpleDependency
+
+	struct ArrayRestrictions {
+		uint64_t min_items;
+		uint64_t max_items;
+		uint32_t unique_items;
+		// Node of all items or list of nodes of first items or kNone.
+		uint32_t items;
+		uint32_t items_list;
+		uint32_t additional;
+		uint32_t additional_items;
+		uint32_t padding;
+	}; // struct ArrayRestrictions
+
+	struct AnyRestrictions {
+		// List of nodes of disallowed types or kNone.
+		uint32_t disallow;
+		uint32_t has_enum;
+		// Nodes of types of value kinds by index of bit of JsonValueKind or kNone.
+		uint32_t kind_types[7];
+		uint32_t padding;
+	}; // struct AnyRestrictions
+
+	// Table of names built by NameTable, which is restored from it without search of hashes.
+	struct NameTableLayout {
+		uint64_t seed;
+		// List of strings of names.
+		uint32_t names;
+		// Words of displacements of buckets.
+		uint32_t displacements;
+		// List of indexes of names in slots (kNone for free slots).
+		uint32_t slots;
+		uint32_t padding;
+	}; // struct NameTableLayout
+
+	// Lowering of linked tree of types (see JsonType::Lower).
+	class Builder {
+	public:
+		explicit Builder(SchemaProgram &program);
+
+		// Return index of node of type, type is lowered on the first request. Index is assigned
+		// before lowering, so recursive references are lowered to the same node.
+		uint32_t AddNode(JsonType const &type);
+		uint32_t AddNodes(std::vector<JsonTypePtr> const &types);
+		uint32_t AddList(std::vector<uint32_t> const &items);
+		uint32_t AddString(char const *string);
+		uint32_t AddEnum(JsonValueSet const &values);
+		uint32_t AddExternalRef(ExternalRefPtr const &ref);
+		uint32_t AddMask(NameSet::Mask const &mask);
+		uint32_t AddNameTable(NameTable const &table);
+		uint32_t AddRegex(RegexPtr const &regex);
+		uint32_t AddRegexSet(RegexSetPtr const &regex_set);
+
+		uint32_t Add(StringRestrictions const &restrictions);
+		uint32_t Add(NumberRestrictions<double> const &restrictions);
+		uint32_t Add(NumberRestrictions<long long> const &restrictions);
+		uint32_t Add(ObjectRestrictions const &restrictions);
+		uint32_t Add(SimpleDependency const &dependency);
+		uint32_t Add(ArrayRestrictions const &restrictions);
+		uint32_t Add(AnyRestrictions const &restrictions);
+
+	private:
+		uint32_t AddWords(uint64_t const *words, size_t count);
+
+		SchemaProgram &program_;
+		std::unordered_map<JsonType const *, uint32_t> nodes_;
+	}; // class Builder
+
+	explicit SchemaProgram(JsonType const &root);
+	// Read program written to image by Write. Exception 'IncorrectSchema' is thrown if program
+	// refers out of its tables or its nodes validate the same value recursively.
+	SchemaProgram(BinarySchema const &image, JsonResolverPtr const &resolver);
+
+	SchemaProgram(SchemaProgram const &) = delete;
+	SchemaProgram &operator=(SchemaProgram const &) = delete;
+
+	void Validate(JsonValue const &json, ValidationContext &context) const;
+	void Validate(uint32_t index, JsonValue const &json, ValidationContext &context) const;
+
+	// Support of streaming validation (see StreamValidator), root of document is validated by
+	// node 0. Nodes which check container of given type incrementally are added to 'nodes', false
+	// is returned if container must be collected and validated by Validate. Names of object
+	// members are not kept, node marks known names in set prepared by StartObject.
+	bool GetStreamNodes(uint32_t index, rapidjson::Type type, std::vector<uint32_t> &nodes) const;
+	void StartObject(uint32_t index, NameSet &present_names) const;
+	void GetMemberNodes(uint32_t index, char const *name, JsonSizeType length,
+	                    std::vector<uint32_t> &nodes, NameSet &present_names,
+	                    ValidationContext &context) const;
+	void GetElementNodes(uint32_t index, JsonSizeType element, std::vector<uint32_t> &nodes,
+	                     ValidationContext &context) const;
+	void FinishObject(uint32_t index, NameSet const &present_names,
+	                  ValidationContext &context) const;
+	void FinishArray(uint32_t index, JsonSizeType size, ValidationContext &context) const;
+
+	size_t GetNodesCount() const;
+
+	// Append program to image, values of enums are referred by indexes of their records in image.
+	void Write(std::unordered_map<JsonValue const *, uint32_t> const &value_records,
+	           std::string &image) const;
+
+private:
+	// Errors raised by node are created by program, program has such source for every node.
+	class NodeErrors : public ErrorSource {
+	public:
+		NodeErrors(SchemaProgram const &program, uint32_t node);
+
+		virtual DocumentErrorPtr CreateError(DocumentErrors error, char const *name) const;
+
+	private:
+		SchemaProgram const *program_;
+		uint32_t node_;
+	}; // class NodeErrors
+
+	void ValidateRef(Node const &node, JsonValue const &json, ValidationContext &context) const;
+	void ValidateString(uint32_t index, StringRestrictions const &string, JsonValue const &json,
+	                    ValidationContext &context) const;
+	template <typename Type>
+	void ValidateNumber(uint32_t index, NumberRestrictions<Type> const &number,
+	                    JsonValue const &json, ValidationContext &context) const;
+	void ValidateObject(uint32_t index, ObjectRestrictions const &object, JsonValue const &json,
+	                    ValidationContext &context) const;
+	void ValidateArray(uint32_t index, ArrayRestrictions const &array, JsonValue const &json,
+	                   ValidationContext &context) const;
+	// Whether value is valid for one of nodes of list.
+	bool IsValidForAny(uint32_t list, JsonValue const &json) const;
+	// Regular expressions of read program are compiled on first use.
+	Regex const &GetRegex(uint32_t regex) const;
+	RegexSet const &GetRegexSet(uint32_t regex_set) const;
+
+	void RaiseError(uint32_t index, ValidationContext &context, JsonValue const &json,
+	                DocumentErrors error, char const *name = nullptr) const;
+	// Error of streamed value, which is not available.
+	void RaiseError(uint32_t index, ValidationContext &context, DocumentErrors error,
+	                char const *name = nullptr) const;
+	DocumentErrorPtr CreateError(uint32_t index, DocumentErrors error, char const *name) const;
+
+	// Items of list follow its size.
+	uint32_t const *GetList(uint32_t list) const;
+	char const *GetString(uint32_t string) const;
+	void Finish();
+
+	void ReadEnums(BinarySchema const &image, std::vector<uint32_t> const &enum_records);
+	void CheckTables() const;
+	void CheckNode(Node const &node) const;
+	void CheckObject(ObjectRestrictions const &object) const;
+	void CheckArray(ArrayRestrictions const &array) const;
+	void CheckAny(AnyRestrictions const &any) const;
+	// Throw exception with given error if validation of value can lead to its validation by the
+	// same node.
+	void CheckRecursion(SchemaErrors error) const;
+	// Nodes which validate the same value as node with given index.
+	void GetSameValueNodes(uint32_t index, std::vector<uint32_t> &nodes) const;
+	bool IsNode(uint32_t node) const;
+	bool IsList(uint32_t list) const;
+	bool IsNodesList(uint32_t list) const;
+	bool IsStringsList(uint32_t list) const;
+	bool IsWords(uint32_t words) const;
+	// Mask of names of table with given count of names.
+	bool IsMask(uint32_t mask, size_t names_count) const;
+	bool IsString(uint32_t string) const;
+
+	std::vector<Node> nodes_;
+	// Lists of nodes, strings or indexes.
+	std::vector<uint32_t> lists_;
+	// Masks of names and displacements of name tables, words follow their count.
+	std::vector<uint64_t> words_;
+	// Zero-terminated strings referred by offsets.
+	std::string strings_;
+
+	std::vector<StringRestrictions> strings_restrictions_;
+	std::vector<NumberRestrictions<double>> numbers_restrictions_;
+	std::vector<NumberRestrictions<long long>> integers_restrictions_;
+	std::vector<ObjectRestrictions> objects_restrictions_;
+	std::vector<SimpleDependency> simple_dependencies_;
+	std::vector<ArrayRestrictions> arrays_restrictions_;
+	std::vector<AnyRestrictions> any_restrictions_;
+
+	std::vector<NameTableLayout> name_table_layouts_;
+	std::vector<NameTable> name_tables_;
+	// Patterns are strings, patterns of set are list of strings.
+	std::vector<uint32_t> regex_patterns_;
+	mutable std::vector<RegexPtr> regexes_;
+	mutable std::vector<std::once_flag> regexes_flags_;
+	std::vector<uint32_t> regex_set_patterns_;
+	mutable std::vector<RegexSetPtr> regex_sets_;
+	mutable std::vector<std::once_flag> regex_sets_flags_;
+	// Values of enums of read program are read from image to own document.
+	JsonDocument values_;
+	std::vector<JsonValueSet> enums_;
+	std::vector<ExternalRefPtr> external_refs_;
+
+	std::vector<NodeErrors> errors_;
+}; // class SchemaProgram
+
+typedef std::unique_ptr<SchemaProgram> SchemaProgramPtr;
+
+} // namespace JsonSchemaValidator
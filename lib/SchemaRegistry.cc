@@ -0,0 +1,324 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "../include/SchemaRegistry.h"
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "../include/JsonSchema.h"
+#include "../include/JsonErrors.h"
+
+#include "RapidJsonHelpers.h"
+
+namespace JsonSchemaValidator {
+
+namespace {
+
+// Empty fragment refers to the whole schema, so "a.json#" and "a.json" are the same schema.
+std::string NormalizeUri(std::string const &uri) {
+	if (!uri.empty() && uri.back() == '#') {
+		return uri.substr(0, uri.size() - 1);
+	}
+	return uri;
+}
+
+// References to other schemas are bound during compilation, so compiled schema having them
+// depends on registered schemas and can't be shared by content.
+bool HasExternalRefs(JsonValue const &schema) {
+	if (schema.IsObject()) {
+		for (auto member = schema.MemberBegin(); member != schema.MemberEnd(); ++member) {
+			if (member->name == "$ref" && member->value.IsString() &&
+			    member->value.GetString()[0] != '#') {
+				return true;
+			}
+			if (HasExternalRefs(member->value)) {
+				return true;
+			}
+		}
+	}
+	else if (schema.IsArray()) {
+		for (auto element = schema.Begin(); element != schema.End(); ++element) {
+			if (HasExternalRefs(*element)) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// Compiled schema with its document.
+struct CompiledSchema {
+	JsonDocument document;
+	std::unique_ptr<JsonSchema> schema;
+	bool trusted;
+}; // struct CompiledSchema
+
+typedef std::shared_ptr<CompiledSchema> CompiledSchemaPtr;
+
+// Readers are spread over groups by threads, so threads rarely change the same counters.
+size_t const kReadersGroups = 32;
+std::atomic<size_t> next_readers_group(0);
+
+size_t GetReadersGroup() {
+	thread_local size_t readers_group = next_readers_group++ % kReadersGroups;
+	return readers_group;
+}
+
+// Registries having readers in current thread. Writer waits for readers, so these registries
+// can't be changed by this thread.
+thread_local std::vector<void const *> read_registries;
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Registered names. Published names are never changed: writer changes copy and publishes it.
+struct SchemaRegistry::Names {
+	std::unordered_map<std::string, JsonSchemaPtr> schemas;
+	std::unordered_map<std::string, std::string> aliases;
+
+	JsonSchemaPtr const *Find(std::string const &ref) const;
+}; // struct SchemaRegistry::Names
+
+JsonSchemaPtr const *SchemaRegistry::Names::Find(std::string const &ref) const {
+	if (!ref.empty() && ref.back() == '#') {
+		return Find(NormalizeUri(ref));
+	}
+	auto schema = schemas.find(ref);
+	if (schema == schemas.end()) {
+		auto alias = aliases.find(ref);
+		if (alias == aliases.end()) {
+			return nullptr;
+		}
+		schema = schemas.find(alias->second);
+	}
+	return schema != schemas.end() ? &schema->second : nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Names are replaced as in SRCU: reader increments counter of current parity of epoch before
+// taking names, writer publishes new names and waits until counters of both parities are zero
+// (after changing of epoch new readers don't use counters of previous parity). Readers which took
+// previous names are finished then, so previous names are destroyed.
+struct SchemaRegistry::Impl {
+	// Counters of readers group are placed in own cache line.
+	struct Readers {
+		std::atomic<size_t> counters[2];
+		char padding[64 - 2 * sizeof(std::atomic<size_t>)];
+	}; // struct Readers
+
+	std::atomic<Names const *> names_;
+	std::atomic<size_t> epoch_;
+	Readers readers_[kReadersGroups];
+
+	std::mutex write_mutex_;
+	// Compiled schemas by hash of content. Schemas aren't owned by cache, they are destroyed
+	// when no longer registered and used.
+	std::unordered_multimap<size_t, std::weak_ptr<CompiledSchema>> compiled_;
+	// Resolver of compiled schemas. It doesn't own registry, because registry owns schemas.
+	JsonResolverPtr resolver_;
+
+	Impl();
+	~Impl();
+
+	std::atomic<size_t> &EnterReader();
+	void CheckWriter() const;
+	JsonSchemaPtr Find(std::string const &ref);
+	JsonSchemaPtr Compile(CompiledSchemaPtr const &compiled);
+	// Following methods are called with locked write_mutex_.
+	void Register(std::string const &uri, JsonSchemaPtr const &schema, JsonValue const &document);
+	void Publish(Names const *names);
+}; // struct SchemaRegistry::Impl
+
+class SchemaRegistry::Resolver : public JsonResolver {
+public:
+	explicit Resolver(std::weak_ptr<SchemaRegistry::Impl> const &registry);
+	virtual ~Resolver();
+
+	virtual JsonSchemaPtr Resolve(std::string const &ref) const;
+
+private:
+	std::weak_ptr<SchemaRegistry::Impl> registry_;
+}; // class SchemaRegistry::Resolver
+
+SchemaRegistry::Resolver::Resolver(std::weak_ptr<SchemaRegistry::Impl> const &registry)
+	: registry_(registry) {
+}
+
+SchemaRegistry::Resolver::~Resolver() {
+}
+
+JsonSchemaPtr SchemaRegistry::Resolver::Resolve(std::string const &ref) const {
+	std::shared_ptr<SchemaRegistry::Impl> registry = registry_.lock();
+	return registry ? registry->Find(ref) : JsonSchemaPtr();
+}
+
+SchemaRegistry::Impl::Impl()
+	: names_(new Names())
+	, epoch_(0)
+	, readers_()
+	, write_mutex_()
+	, compiled_()
+	, resolver_() {
+}
+
+SchemaRegistry::Impl::~Impl() {
+	delete names_.load();
+}
+
+std::atomic<size_t> &SchemaRegistry::Impl::EnterReader() {
+	std::atomic<size_t> &readers = readers_[GetReadersGroup()].counters[epoch_.load() & 1];
+	++readers;
+	return readers;
+}
+
+void SchemaRegistry::Impl::CheckWriter() const {
+	if (std::find(read_registries.begin(), read_registries.end(), this) !=
+	    read_registries.end()) {
+		throw std::logic_error("SchemaRegistry is changed by thread having its reader");
+	}
+}
+
+JsonSchemaPtr SchemaRegistry::Impl::Find(std::string const &ref) {
+	std::atomic<size_t> &readers = EnterReader();
+	JsonSchemaPtr const *schema = names_.load()->Find(ref);
+	JsonSchemaPtr found = schema ? *schema : JsonSchemaPtr();
+	--readers;
+	return found;
+}
+
+JsonSchemaPtr SchemaRegistry::Impl::Compile(CompiledSchemaPtr const &compiled) {
+	bool const shared = !HasExternalRefs(compiled->document);
+	size_t const hash = shared ? GetHash(compiled->document) : 0;
+	// Whole cache is scanned to remove destroyed schemas, schemas are added rarely.
+	for (auto it = compiled_.begin(); it != compiled_.end();) {
+		CompiledSchemaPtr cached = it->second.lock();
+		if (!cached) {
+			it = compiled_.erase(it);
+			continue;
+		}
+		// Schema compiled as trusted isn't reused for untrusted one, which must be checked.
+		if (shared && it->first == hash && (compiled->trusted || !cached->trusted) &&
+		    IsEqual(cached->document, compiled->document)) {
+			return JsonSchemaPtr(cached, cached->schema.get());
+		}
+		++it;
+	}
+
+	JsonSchemaOptions options;
+	options.resolver = resolver_;
+	options.trusted = compiled->trusted;
+	compiled->schema.reset(new JsonSchema(compiled->document, options));
+	if (shared) {
+		compiled_.insert({hash, compiled});
+	}
+	return JsonSchemaPtr(compiled, compiled->schema.get());
+}
+
+void SchemaRegistry::Impl::Register(std::string const &uri, JsonSchemaPtr const &schema,
+                                    JsonValue const &document) {
+	std::unique_ptr<Names> names(new Names(*names_.load()));
+	names->schemas[uri] = schema;
+
+	std::string id;
+	if (GetChildValue(document, "id", id)) {
+		id = NormalizeUri(id);
+		if (id != uri) {
+			names->aliases[id] = uri;
+		}
+	}
+	Publish(names.release());
+}
+
+void SchemaRegistry::Impl::Publish(Names const *names) {
+	std::unique_ptr<Names const> previous(names_.exchange(names));
+	// Reader could read epoch before previous change and increment counter of other parity
+	// after it, so both parities are waited.
+	for (int i = 0; i < 2; ++i) {
+		size_t const parity = epoch_++ & 1;
+		for (auto &readers : readers_) {
+			while (readers.counters[parity].load() != 0) {
+				std::this_thread::yield();
+			}
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+SchemaRegistry::SchemaRegistry()
+	: JsonResolver()
+	, impl_(std::make_shared<Impl>()) {
+	impl_->resolver_ = std::make_shared<Resolver>(impl_);
+}
+
+SchemaRegistry::~SchemaRegistry() {
+}
+
+JsonSchemaPtr SchemaRegistry::Add(std::string const &uri, char const *schema, bool trusted) {
+	CompiledSchemaPtr compiled(new CompiledSchema{JsonDocument(), nullptr, trusted});
+	compiled->document.Parse<0>(schema);
+	if (compiled->document.HasParseError()) {
+		throw IncorrectJson(GetLastError(compiled->document));
+	}
+
+	impl_->CheckWriter();
+	std::lock_guard<std::mutex> lock(impl_->write_mutex_);
+	JsonSchemaPtr compiled_schema = impl_->Compile(compiled);
+	impl_->Register(NormalizeUri(uri), compiled_schema, compiled->document);
+	return compiled_schema;
+}
+
+JsonSchemaPtr SchemaRegistry::Add(std::string const &uri, std::string const &schema,
+                                  bool trusted) {
+	return Add(uri, schema.c_str(), trusted);
+}
+
+void SchemaRegistry::AddAlias(std::string const &alias, std::string const &uri) {
+	impl_->CheckWriter();
+	std::lock_guard<std::mutex> lock(impl_->write_mutex_);
+	std::unique_ptr<Names> names(new Names(*impl_->names_.load()));
+	names->aliases[NormalizeUri(alias)] = NormalizeUri(uri);
+	impl_->Publish(names.release());
+}
+
+JsonSchemaPtr SchemaRegistry::Resolve(std::string const &ref) const {
+	return impl_->Find(ref);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+SchemaRegistry::Reader::Reader(SchemaRegistry const &registry)
+	: registry_(registry.impl_.get())
+	, readers_(registry.impl_->EnterReader())
+	, names_(registry.impl_->names_.load()) {
+	read_registries.push_back(registry_);
+}
+
+SchemaRegistry::Reader::~Reader() {
+	// Readers are usually destroyed in reverse order, so search starts from the end.
+	auto it = std::find(read_registries.rbegin(), read_registries.rend(), registry_);
+	read_registries.erase(std::next(it).base());
+	--readers_;
+}
+
+JsonSchema const *SchemaRegistry::Reader::Find(std::string const &uri) const {
+	JsonSchemaPtr const *schema = names_->Find(uri);
+	return schema ? schema->get() : nullptr;
+}
+
+} // namespace JsonSchemaValidator
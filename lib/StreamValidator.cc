@@ -0,0 +1,276 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "StreamValidator.h"
+
+#include <string>
+
+#include <JsonErrors.h>
+
+#include "SchemaProgram.h"
+#include "ValidationContext.h"
+
+namespace JsonSchemaValidator {
+
+StreamValidator::StreamValidator(SchemaProgram const &program, ValidationContext &context)
+	: program_(program)
+	, context_(context)
+	, frames_()
+	, depth_(0)
+	, value_nodes_(1, 0)
+	, buffer_()
+	, buffer_values_()
+	, buffer_depth_(0)
+	, buffer_nodes_() {
+}
+
+bool StreamValidator::Null() {
+	JsonValue value;
+	return Value(value);
+}
+
+bool StreamValidator::Bool(bool value) {
+	JsonValue json_value(value);
+	return Value(json_value);
+}
+
+bool StreamValidator::Int(int value) {
+	JsonValue json_value(value);
+	return Value(json_value);
+}
+
+bool StreamValidator::Uint(unsigned value) {
+	JsonValue json_value(value);
+	return Value(json_value);
+}
+
+bool StreamValidator::Int64(int64_t value) {
+	JsonValue json_value(value);
+	return Value(json_value);
+}
+
+bool StreamValidator::Uint64(uint64_t value) {
+	JsonValue json_value(value);
+	return Value(json_value);
+}
+
+bool StreamValidator::Double(double value) {
+	JsonValue json_value(value);
+	return Value(json_value);
+}
+
+bool StreamValidator::String(char const *value, JsonSizeType length, bool /*copy*/) {
+	if (buffer_depth_ > 0) {
+		JsonValue json_value(value, length, buffer_.GetAllocator());
+		BufferValue(json_value);
+		return true;
+	}
+	JsonValue json_value(rapidjson::StringRef(value, length));
+	return Value(json_value);
+}
+
+bool StreamValidator::StartObject() {
+	return StartContainer(rapidjson::kObjectType);
+}
+
+bool StreamValidator::Key(char const *name, JsonSizeType length, bool /*copy*/) {
+	if (buffer_depth_ > 0) {
+		JsonValue json_name(name, length, buffer_.GetAllocator());
+		BufferValue(json_name);
+		return true;
+	}
+
+	Frame &frame = frames_[depth_ - 1];
+	frame.name.assign(name, length);
+	value_nodes_.clear();
+	for (size_t i = 0; i < frame.nodes.size(); ++i) {
+		program_.GetMemberNodes(frame.nodes[i], name, length, value_nodes_,
+		                        *frame.present_names[i], context_);
+		if (!context_.GetResult()) {
+			return Fail(false);
+		}
+	}
+	return true;
+}
+
+bool StreamValidator::EndObject(JsonSizeType members_count) {
+	return EndContainer(rapidjson::kObjectType, members_count);
+}
+
+bool StreamValidator::StartArray() {
+	return StartContainer(rapidjson::kArrayType);
+}
+
+bool StreamValidator::EndArray(JsonSizeType elements_count) {
+	return EndContainer(rapidjson::kArrayType, elements_count);
+}
+
+bool StreamValidator::Value(JsonValue &value) {
+	if (buffer_depth_ > 0) {
+		BufferValue(value);
+		return true;
+	}
+	if (!PrepareValue()) {
+		return false;
+	}
+	for (uint32_t node : value_nodes_) {
+		program_.Validate(node, value, context_);
+		if (!context_.GetResult()) {
+			return Fail(true);
+		}
+	}
+	return true;
+}
+
+bool StreamValidator::StartContainer(rapidjson::Type type) {
+	if (buffer_depth_ > 0) {
+		JsonValue container(type);
+		BufferValue(container);
+		++buffer_depth_;
+		return true;
+	}
+	if (!PrepareValue()) {
+		return false;
+	}
+
+	if (depth_ == frames_.size()) {
+		frames_.emplace_back();
+	}
+	Frame &frame = frames_[depth_];
+	frame.nodes.clear();
+	frame.size = 0;
+	frame.is_object = (type == rapidjson::kObjectType);
+
+	for (uint32_t value_node : value_nodes_) {
+		if (!program_.GetStreamNodes(value_node, type, frame.nodes)) {
+			// Value will be validated after it is collected.
+			buffer_nodes_.swap(value_nodes_);
+			JsonValue container(type);
+			BufferValue(container);
+			buffer_depth_ = 1;
+			return true;
+		}
+	}
+	if (frame.is_object) {
+		while (frame.present_names.size() < frame.nodes.size()) {
+			frame.present_names.emplace_back(new NameSet(0));
+		}
+		for (size_t i = 0; i < frame.nodes.size(); ++i) {
+			program_.StartObject(frame.nodes[i], *frame.present_names[i]);
+		}
+	}
+	++depth_;
+	return true;
+}
+
+bool StreamValidator::EndContainer(rapidjson::Type type, JsonSizeType size) {
+	if (buffer_depth_ > 0) {
+		BufferContainer(type, size);
+		if (--buffer_depth_ > 0) {
+			return true;
+		}
+
+		JsonValue value;
+		value.Swap(buffer_values_.back());
+		buffer_values_.clear();
+		for (uint32_t buffer_node : buffer_nodes_) {
+			program_.Validate(buffer_node, value, context_);
+			if (!context_.GetResult()) {
+				return Fail(true);
+			}
+		}
+		buffer_.GetAllocator().Clear();
+		return true;
+	}
+
+	Frame &frame = frames_[depth_ - 1];
+	for (size_t i = 0; i < frame.nodes.size(); ++i) {
+		if (frame.is_object) {
+			program_.FinishObject(frame.nodes[i], *frame.present_names[i], context_);
+		}
+		else {
+			program_.FinishArray(frame.nodes[i], frame.size, context_);
+		}
+		if (!context_.GetResult()) {
+			return Fail(false);
+		}
+	}
+	--depth_;
+	return true;
+}
+
+bool StreamValidator::PrepareValue() {
+	if (depth_ == 0 || frames_[depth_ - 1].is_object) {
+		// Nodes of root value and of object members are already known.
+		return true;
+	}
+
+	Frame &frame = frames_[depth_ - 1];
+	value_nodes_.clear();
+	for (uint32_t node : frame.nodes) {
+		program_.GetElementNodes(node, frame.size, value_nodes_, context_);
+		if (!context_.GetResult()) {
+			return Fail(false);
+		}
+	}
+	++frame.size;
+	return true;
+}
+
+bool StreamValidator::Fail(bool with_current_element) {
+	ValidationResult &result = context_.GetResult();
+	for (size_t depth = depth_; depth > 0; --depth) {
+		Frame const &frame = frames_[depth - 1];
+		if (depth == depth_ && !with_current_element) {
+			continue;
+		}
+		// Stream validation stops on the first error, so it is the only collected error.
+		if (frame.is_object) {
+			result.AddPath(frame.name.c_str());
+			result.AddErrorsPath(frame.name.c_str(), 0);
+		}
+		else {
+			result.AddPath(frame.size - 1);
+			result.AddErrorsPath(frame.size - 1, 0);
+		}
+	}
+	return false;
+}
+
+void StreamValidator::BufferValue(JsonValue &value) {
+	buffer_values_.emplace_back();
+	buffer_values_.back().Swap(value);
+}
+
+void StreamValidator::BufferContainer(rapidjson::Type type, JsonSizeType size) {
+	auto &allocator = buffer_.GetAllocator();
+	bool is_object = (type == rapidjson::kObjectType);
+	size_t values_count = is_object ? 2 * size : size;
+	size_t first = buffer_values_.size() - values_count;
+
+	JsonValue &container = buffer_values_[first - 1];
+	if (is_object) {
+		for (size_t i = first; i < buffer_values_.size(); i += 2) {
+			container.AddMember(buffer_values_[i], buffer_values_[i + 1], allocator);
+		}
+	}
+	else {
+		for (size_t i = first; i < buffer_values_.size(); ++i) {
+			container.PushBack(buffer_values_[i], allocator);
+		}
+	}
+	buffer_values_.resize(first);
+}
+
+} // namespace JsonSchemaValidator
@@ -0,0 +1,87 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <rapidjson/document.h>
+
+#include "Defs.h"
+#include "NameTable.h"
+#include "RapidJsonDefs.h"
+
+namespace JsonSchemaValidator {
+
+class SchemaProgram;
+
+// Handler for rapidjson::Reader which validates json-document during its parsing. Objects and
+// arrays are checked incrementally while their schemas allow it (see
+// SchemaProgram::GetStreamNodes), other values are collected into DOM and validated as whole. So used memory depends on depth
+// of document and on size of collected values, but not on size of whole document: names of
+// members are not kept, only current name of every object is.
+class StreamValidator {
+public:
+	StreamValidator(SchemaProgram const &program, ValidationContext &context);
+
+	bool Null();
+	bool Bool(bool value);
+	bool Int(int value);
+	bool Uint(unsigned value);
+	bool Int64(int64_t value);
+	bool Uint64(uint64_t value);
+	bool Double(double value);
+	bool String(char const *value, JsonSizeType length, bool copy);
+	bool StartObject();
+	bool Key(char const *name, JsonSizeType length, bool copy);
+	bool EndObject(JsonSizeType members_count);
+	bool StartArray();
+	bool EndArray(JsonSizeType elements_count);
+
+private:
+	struct Frame {
+		std::vector<uint32_t> nodes;
+		// Names of object known by every node.
+		std::vector<std::unique_ptr<NameSet>> present_names;
+		std::string name;
+		JsonSizeType size;
+		bool is_object;
+	}; // struct Frame
+
+	bool Value(JsonValue &value);
+	bool StartContainer(rapidjson::Type type);
+	bool EndContainer(rapidjson::Type type, JsonSizeType size);
+	bool PrepareValue();
+	bool Fail(bool with_current_element);
+
+	void BufferValue(JsonValue &value);
+	void BufferContainer(rapidjson::Type type, JsonSizeType size);
+
+	SchemaProgram const &program_;
+	ValidationContext &context_;
+
+	std::vector<Frame> frames_;
+	size_t depth_;
+	std::vector<uint32_t> value_nodes_;
+
+	JsonDocument buffer_;
+	std::vector<JsonValue> buffer_values_;
+	size_t buffer_depth_;
+	std::vector<uint32_t> buffer_nodes_;
+}; // class StreamValidator
+
+} // namespace JsonSchemaValidator
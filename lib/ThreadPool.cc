@@ -0,0 +1,226 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace JsonSchemaValidator {
+
+namespace {
+
+// Pool and index of queue of current worker thread.
+thread_local ThreadPool const *current_pool = nullptr;
+thread_local size_t current_queue = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t workers_count)
+	: queues_()
+	, workers_()
+	, pending_tasks_(0)
+	, next_queue_(0)
+	, mutex_()
+	, condition_()
+	, stop_(false) {
+
+	workers_count = std::max<size_t>(workers_count, 1);
+	for (size_t i = 0; i < workers_count; ++i) {
+		queues_.emplace_back(new Queue());
+	}
+	for (size_t i = 0; i < workers_count; ++i) {
+		workers_.emplace_back(&ThreadPool::Work, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	condition_.notify_all();
+	for (auto &worker : workers_) {
+		worker.join();
+	}
+}
+
+size_t ThreadPool::GetWorkersCount() const {
+	return workers_.size();
+}
+
+void ThreadPool::Submit(Task task) {
+	size_t index = (current_pool == this) ? current_queue : (next_queue_++ % queues_.size());
+	{
+		// Counter is increased before task is queued, so it never becomes less than count of
+		// queued tasks.
+		std::lock_guard<std::mutex> lock(mutex_);
+		++pending_tasks_;
+	}
+	{
+		std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+		queues_[index]->tasks.push_back(std::move(task));
+	}
+	condition_.notify_one();
+}
+
+ThreadPool &ThreadPool::Instance() {
+	static ThreadPool pool(std::thread::hardware_concurrency());
+	return pool;
+}
+
+void ThreadPool::Work(size_t index) {
+	current_pool = this;
+	current_queue = index;
+
+	Task task;
+	while (true) {
+		if (PopTask(index, task)) {
+			task();
+			task = nullptr;
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(mutex_);
+		condition_.wait(lock, [this] { return stop_ || pending_tasks_ > 0; });
+		if (stop_) {
+			return;
+		}
+	}
+}
+
+bool ThreadPool::PopTask(size_t index, Task &task) {
+	{
+		Queue &queue = *queues_[index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			--pending_tasks_;
+			return true;
+		}
+	}
+	return StealTask(index + 1, task);
+}
+
+bool ThreadPool::StealTask(size_t index, Task &task) {
+	if (pending_tasks_ == 0) {
+		return false;
+	}
+	for (size_t i = 0; i < queues_.size(); ++i) {
+		Queue &queue = *queues_[(index + i) % queues_.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+			--pending_tasks_;
+			return true;
+		}
+	}
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct TaskGroup::State {
+	State();
+
+	// Execute one of not started tasks of group, return false if all tasks are started.
+	bool RunTask();
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::deque<ThreadPool::Task> tasks;
+	size_t running_tasks;
+	std::exception_ptr exception;
+}; // struct TaskGroup::State
+
+TaskGroup::State::State()
+	: mutex()
+	, condition()
+	, tasks()
+	, running_tasks(0)
+	, exception() {
+}
+
+bool TaskGroup::State::RunTask() {
+	ThreadPool::Task task;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (tasks.empty()) {
+			return false;
+		}
+		task = std::move(tasks.front());
+		tasks.pop_front();
+	}
+
+	std::exception_ptr task_exception;
+	try {
+		task();
+	}
+	catch (...) {
+		task_exception = std::current_exception();
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (task_exception && !exception) {
+		exception = task_exception;
+	}
+	if (--running_tasks == 0) {
+		condition.notify_all();
+	}
+	return true;
+}
+
+TaskGroup::TaskGroup(ThreadPool &pool)
+	: pool_(pool)
+	, state_(std::make_shared<State>()) {
+}
+
+TaskGroup::~TaskGroup() {
+	// Tasks refer to data of creator of group, so it can't be destroyed before they are finished.
+	Finish();
+}
+
+void TaskGroup::Run(ThreadPool::Task task) {
+	{
+		std::lock_guard<std::mutex> lock(state_->mutex);
+		state_->tasks.push_back(std::move(task));
+		++state_->running_tasks;
+	}
+	// Every task of pool executes one task of group, if it is not executed by waiting thread yet.
+	std::shared_ptr<State> state = state_;
+	pool_.Submit([state] { state->RunTask(); });
+}
+
+void TaskGroup::Wait() {
+	Finish();
+
+	std::exception_ptr exception;
+	{
+		std::lock_guard<std::mutex> lock(state_->mutex);
+		exception.swap(state_->exception);
+	}
+	if (exception) {
+		std::rethrow_exception(exception);
+	}
+}
+
+void TaskGroup::Finish() {
+	while (state_->RunTask()) {
+	}
+	// Remaining tasks are executed by other threads.
+	std::unique_lock<std::mutex> lock(state_->mutex);
+	state_->condition.wait(lock, [this] { return state_->running_tasks == 0; });
+}
+
+} // namespace JsonSchemaValidator
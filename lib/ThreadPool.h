@@ -0,0 +1,97 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+namespace JsonSchemaValidator {
+
+// Pool of threads with own queue of tasks for every worker. Worker takes the newest task from
+// own queue and, when it is empty, steals the oldest task from queues of other workers. Tasks
+// submitted from worker are put in its own queue, so nested tasks are executed by the same
+// worker while other workers are busy.
+class ThreadPool {
+public:
+	typedef std::function<void()> Task;
+
+	explicit ThreadPool(size_t workers_count);
+	~ThreadPool();
+
+	ThreadPool(ThreadPool const &) = delete;
+	ThreadPool &operator=(ThreadPool const &) = delete;
+
+	size_t GetWorkersCount() const;
+
+	void Submit(Task task);
+
+	// Pool shared by whole library, it has one worker for every hardware thread.
+	static ThreadPool &Instance();
+
+private:
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	}; // struct Queue
+
+	void Work(size_t index);
+	bool PopTask(size_t index, Task &task);
+	bool StealTask(size_t index, Task &task);
+
+	std::vector<std::unique_ptr<Queue>> queues_;
+	std::vector<std::thread> workers_;
+
+	std::atomic<size_t> pending_tasks_;
+	std::atomic<size_t> next_queue_;
+
+	std::mutex mutex_;
+	std::condition_variable condition_;
+	bool stop_;
+}; // class ThreadPool
+
+// Set of tasks executed in pool, which can be waited for. Waiting thread executes tasks of the
+// group which are not started yet instead of blocking, so group can be waited from task of the
+// same pool. Tasks of other groups are never executed by waiting thread: they could use the same
+// thread local data as interrupted task. First exception thrown by tasks is rethrown by Wait.
+class TaskGroup {
+public:
+	explicit TaskGroup(ThreadPool &pool);
+	~TaskGroup();
+
+	TaskGroup(TaskGroup const &) = delete;
+	TaskGroup &operator=(TaskGroup const &) = delete;
+
+	void Run(ThreadPool::Task task);
+	void Wait();
+
+private:
+	// State is shared with tasks submitted to pool, because they can be taken by pool after
+	// group is finished and destroyed.
+	struct State;
+
+	void Finish();
+
+	ThreadPool &pool_;
+	std::shared_ptr<State> state_;
+}; // class TaskGroup
+
+} // namespace JsonSchemaValidator
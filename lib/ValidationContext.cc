@@ -14,30 +14,90 @@
 
 #include "ValidationContext.h"
 
-#include <string>
-
 namespace JsonSchemaValidator {
 
-ValidationContext::ValidationContext(ValidationResult &result)
-	: result_(result) {
+ValidationContext::ValidationContext(ValidationResult &result, bool track_path)
+	: result_(result)
+	, track_path_(track_path)
+	, failed_(false)
+	, errors_count_(0)
+	, parallel_items_threshold_(0)
+	, pinned_count_(0)
+	, pinned_keys_()
+	, pinned_schemas_() {
 }
 
 ValidationContext::~ValidationContext() {
+	if (!result_) {
+		for (size_t i = 0; i < pinned_count_; ++i) {
+			result_.KeepSchema(pinned_schemas_[i]);
+		}
+	}
 }
 
 ValidationResult& ValidationContext::GetResult() {
 	return result_;
 }
 
-///////////////////////////////////////////////////////////////////////////////////////////////////
-template <>
-std::string PathHolder<char const *>::ElementNameToString() const {
-	return name_;
+bool ValidationContext::IsPathTracked() const {
+	return track_path_;
+}
+
+void ValidationContext::RaiseError(DocumentErrors error, ErrorSource const *type,
+                                   JsonValue const *instance, char const *name) {
+	result_.AddError(error, type, instance, name);
+	failed_ = true;
+	++errors_count_;
+}
+
+bool ValidationContext::IsFailed() const {
+	return failed_;
+}
+
+bool ValidationContext::Recover() {
+	if (result_.GetMaxErrors() > 1 && result_.GetErrors().size() < result_.GetMaxErrors()) {
+		failed_ = false;
+	}
+	return !failed_;
+}
+
+void ValidationContext::Merge(ValidationResult const &result) {
+	if (!result) {
+		result_.Append(result);
+		failed_ = true;
+		++errors_count_;
+	}
+}
+
+void ValidationContext::SetParallelItemsThreshold(size_t threshold) {
+	parallel_items_threshold_ = threshold;
+}
+
+size_t ValidationContext::GetParallelItemsThreshold() const {
+	return parallel_items_threshold_;
+}
+
+bool ValidationContext::IsPinned(void const *key) const {
+	for (size_t i = 0; i < pinned_count_; ++i) {
+		if (pinned_keys_[i] == key) {
+			return true;
+		}
+	}
+	return false;
+}
+
+size_t ValidationContext::GetErrorsCount() const {
+	return errors_count_;
 }
 
-template <>
-std::string PathHolder<rapidjson::SizeType>::ElementNameToString() const {
-	return "[" + std::to_string(name_) + "]";
+bool ValidationContext::Pin(void const *key, JsonSchemaPtr const &schema) {
+	if (pinned_count_ == kMaxPinnedSchemas) {
+		return false;
+	}
+	pinned_keys_[pinned_count_] = key;
+	pinned_schemas_[pinned_count_] = schema;
+	++pinned_count_;
+	return true;
 }
 
 } // namespace JsonSchemaValidator
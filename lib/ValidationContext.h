@@ -14,18 +14,57 @@
 
 #pragma once
 
+#include <JsonErrors.h>
+
 #include "Defs.h"
 
 namespace JsonSchemaValidator {
 
 class ValidationContext {
 public:
-	explicit ValidationContext(ValidationResult &result);
+	// Context without path tracking is used when only validity of document is needed (e.g. by
+	// JsonSchema::IsValid or for nested checks of union types), so paths are not added to errors.
+	explicit ValidationContext(ValidationResult &result, bool track_path = true);
 	~ValidationContext();
 
 	ValidationResult& GetResult();
+	bool IsPathTracked() const;
+
+	void RaiseError(DocumentErrors error, ErrorSource const *type, JsonValue const *instance,
+	                char const *name);
+	// Whether error was raised in validated value, so its validation must be stopped.
+	bool IsFailed() const;
+	// Allow to continue validation of other values after error, if result collects errors and
+	// its limit of errors is not reached.
+	bool Recover();
+	// Add errors of values validated by other context (e.g. in other thread).
+	void Merge(ValidationResult const &result);
+
+	// Elements of larger arrays are validated in parallel, 0 disables parallel validation.
+	void SetParallelItemsThreshold(size_t threshold);
+	size_t GetParallelItemsThreshold() const;
+
+	// Schemas referenced by '$ref' are kept alive by context until the end of validation, so
+	// reference counter of schema is changed once per validation instead of every reference.
+	// Pin returns false if context has no room for schema, then caller keeps schema itself and
+	// passes it to result, if errors count is changed by validation. Pinned schemas are passed
+	// to failed result on destruction of context, because errors refer to their nodes.
+	bool IsPinned(void const *key) const;
+	bool Pin(void const *key, JsonSchemaPtr const &schema);
+	// Count of errors raised in this context and merged to it.
+	size_t GetErrorsCount() const;
+
 private:
+	static size_t const kMaxPinnedSchemas = 4;
+
 	ValidationResult &result_;
+	bool track_path_;
+	bool failed_;
+	size_t errors_count_;
+	size_t parallel_items_threshold_;
+	size_t pinned_count_;
+	void const *pinned_keys_[kMaxPinnedSchemas];
+	JsonSchemaPtr pinned_schemas_[kMaxPinnedSchemas];
 }; // class ValidationContext
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -35,12 +74,13 @@ public:
 	PathHolder(ElementName const &name, ValidationContext &context);
 	~PathHolder();
 
+	// Add path to errors raised so far, following errors are raised outside of the element.
 	void Reset();
 
 private:
-	std::string ElementNameToString() const;
-
 	bool need_set_;
+	// Collected errors raised inside of holder get path too, SIZE_MAX if errors aren't collected.
+	size_t first_error_;
 	ElementName name_;
 	ValidationContext &context_;
 }; // class PathHolder
@@ -14,6 +14,8 @@
 
 #include "ValidationContext.h"
 
+#include <cstdint>
+
 #include <JsonErrors.h>
 
 #include "Defs.h"
@@ -22,21 +24,30 @@ namespace JsonSchemaValidator {
 
 template <typename ElementName>
 PathHolder<ElementName>::PathHolder(ElementName const &name, ValidationContext &context)
-	: need_set_(true)
+	: need_set_(context.IsPathTracked() && context.GetResult())
+	, first_error_(context.IsPathTracked() && context.GetResult().GetMaxErrors() > 1 ?
+	               context.GetResult().GetErrors().size() : SIZE_MAX)
 	, name_(name)
 	, context_(context) {
 }
 
 template <typename ElementName>
 PathHolder<ElementName>::~PathHolder() {
-	if (need_set_) {
-		context_.GetResult().AddPath(ElementNameToString());
-	}
+	Reset();
 }
 
 template <typename ElementName>
 void PathHolder<ElementName>::Reset() {
+	// Path is added only to the first error, which is raised inside of this holder.
+	ValidationResult &result = context_.GetResult();
+	if (need_set_ && !result) {
+		result.AddPath(name_);
+	}
+	if (first_error_ < result.GetErrors().size()) {
+		result.AddErrorsPath(name_, first_error_);
+	}
 	need_set_ = false;
+	first_error_ = SIZE_MAX;
 }
 
 } // namespace JsonSchemaValidator
@@ -15,7 +15,7 @@
 include(../common.pri)
 
 TEMPLATE = lib
-CONFIG += staticlib create_prl
+CONFIG += staticlib create_prl thread
 
 QT -= core gui
 
@@ -25,11 +25,22 @@ HEADERS = ../include/JsonResolver.h \
           ../include/JsonErrors.h \
           ../include/JsonSchema.h \
           ../include/JsonDefs.h \
+          ../include/JsonValidator.h \
+          ../include/SchemaRegistry.h \
           RapidJsonDefs.h \
           RapidJsonHelpers.h \
           Defs.h \
+          ArrayElements.h \
+          BinarySchema.h \
+          CheckedSchemas.h \
+          ExternalRef.h \
           JsonType.h \
+          NameTable.h \
           Regex.h \
+          ReusableDocument.h \
+          SchemaProgram.h \
+          StreamValidator.h \
+          ThreadPool.h \
           ValidationContext.h \
           ValidationContext.inl \
           types/JsonTypeImpl.h \
@@ -37,12 +48,23 @@ HEADERS = ../include/JsonResolver.h \
           types/CustomTypes.h \
 
 
-SOURCES = JsonResolver.cc \
+SOURCES = ArrayElements.inl \
+          BinarySchema.cc \
+          CheckedSchemas.cc \
+          ExternalRef.cc \
+          JsonResolver.cc \
           JsonSchema.cc \
           JsonErrors.cc \
           JsonType.cc \
+          JsonValidator.cc \
+          NameTable.cc \
           RapidJsonHelpers.cc \
           Regex.cc \
+          ReusableDocument.cc \
+          SchemaProgram.cc \
+          SchemaRegistry.cc \
+          StreamValidator.cc \
+          ThreadPool.cc \
           ValidationContext.cc \
           types/JsonTypeImpl.inl \
           types/PrimitiveTypes.cc \
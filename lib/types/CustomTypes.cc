@@ -18,96 +18,116 @@
 #include <JsonResolver.h>
 
 #include "../Regex.h"
-#include "../ValidationContext.h"
 
 #include "PrimitiveTypes.h"
 
 namespace JsonSchemaValidator {
 
+namespace {
+
+// Create type for values of one kind only if schema has keywords restricting values of this kind
+// or elements of enum which can be equal to such values.
+template <typename Type, typename ValueType>
+JsonTypePtr CreateKindType(JsonValue const &schema, JsonResolverPtr const &resolver,
+                           std::string const &path, std::initializer_list<char const *> keywords) {
+	std::vector<ValueType> enum_values;
+	bool restricted = GetChildValue(schema, "enum", enum_values) && !enum_values.empty();
+	for (char const *keyword : keywords) {
+		restricted = restricted || FindMember(schema, keyword);
+	}
+	return restricted ? std::make_shared<Type>(schema, resolver, path) : JsonTypePtr();
+}
+
+} // namespace
+
 JsonCustomType::JsonCustomType(JsonValue const &schema, JsonResolverPtr const &resolver,
                                std::string const &path)
 	: JsonType(schema, resolver, path)
 	, custom_type_(JsonType::Create(schema, resolver, path)) {
 }
 
-bool JsonCustomType::CheckValueType(JsonValue const &/*json*/) const {
-	return true;
+void JsonCustomType::Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const {
+	JsonType::Lower(builder, node);
+	node.op = SchemaProgram::kCustomOp;
+	node.restrictions = builder.AddNode(*custom_type_);
 }
 
-void JsonCustomType::CheckTypeRestrictions(JsonValue const &json, ValidationContext &context) const {
-	return custom_type_->Validate(json, context);
+void JsonCustomType::ForEachChild(std::function<void (JsonType const &)> const &function) const {
+	JsonType::ForEachChild(function);
+	function(*custom_type_);
 }
 
-void JsonCustomType::CheckEnumsRestrictions(JsonValue const &/*json*/,
-                                            ValidationContext &/*context*/) const {
-}
-
-///////////////////////////////////////////////////////////////////////////////////////////////////
 JsonAny::JsonAny(JsonValue const &schema, JsonResolverPtr const &resolver,
                  std::string const &path)
 	: JsonType(schema, resolver, path)
 	, disallow_()
-	, string_(std::make_shared<JsonString>(schema, resolver, path))
-	, number_(std::make_shared<JsonNumber>(schema, resolver, path))
-	, integer_(std::make_shared<JsonInteger>(schema, resolver, path))
-	, boolean_(std::make_shared<JsonBoolean>(schema, resolver, path))
-	, object_(std::make_shared<JsonObject>(schema, resolver, path))
-	, array_(std::make_shared<JsonArray>(schema, resolver, path))
-	, null_(std::make_shared<JsonNull>(schema, resolver, path)) {
+	, has_enum_(false)
+	, string_(CreateKindType<JsonString, char const *>(schema, resolver, path,
+	          { "minLength", "maxLength", "pattern" }))
+	, number_(CreateKindType<JsonNumber, double>(schema, resolver, path,
+	          { "minimum", "maximum", "exclusiveMinimum", "exclusiveMaximum", "divisibleBy" }))
+	, integer_(CreateKindType<JsonInteger, long long>(schema, resolver, path,
+	           { "minimum", "maximum", "exclusiveMinimum", "exclusiveMaximum", "divisibleBy" }))
+	, boolean_(CreateKindType<JsonBoolean, bool>(schema, resolver, path, {}))
+	, object_(CreateKindType<JsonObject, JsonObjectValue>(schema, resolver, path,
+	          { "properties", "patternProperties", "additionalProperties", "dependencies" }))
+	, array_(CreateKindType<JsonArray, JsonArrayValue>(schema, resolver, path,
+	         { "items", "additionalItems", "minItems", "maxItems", "uniqueItems" }))
+	, null_(CreateKindType<JsonNull, JsonNullValue>(schema, resolver, path, {})) {
+
+	JsonValueMember const *enum_values = FindMember(schema, "enum");
+	has_enum_ = enum_values && enum_values->value.IsArray();
 
 	JsonValueMember const *disallow = FindMember(schema, "disallow");
 	if (disallow) {
 		if (disallow->value.IsArray()) {
 			for (JsonSizeType i = 0; i < disallow->value.Size(); ++i) {
-				disallow_.insert(CreateJsonTypeFromArrayElement(schema, disallow->value[i],
-				                                                resolver, path));
+				disallow_.push_back(CreateJsonTypeFromArrayElement(schema, disallow->value[i],
+				                                                   resolver, path));
 			}
 		}
 		else if (disallow->value.IsString()) {
 			JsonTypeCreator creator = GetCreator(disallow->value);
-			disallow_.insert(creator((JsonValue()), resolver, path));
+			disallow_.push_back(creator((JsonValue()), resolver, path));
 		}
 		else {
 			RaiseError(SchemaErrors::IncorrectDisallowType);
 		}
 	}
-}
-
-void JsonAny::Validate(JsonValue const &json, ValidationContext &context) const {
-	for (auto const &disallow : disallow_) {
-		ValidationResult disallow_result;
-		ValidationContext disallow_context(disallow_result);
-		disallow->Validate(json, disallow_context);
-		if (disallow_result) {
-			return RaiseError<DisallowTypeError>(context);
-		}
-	}
-	GetSchema(json)->Validate(json, context);
-}
-
-bool JsonAny::CheckValueType(JsonValue const &/*json*/) const {
-	return true;
-}
 
-void JsonAny::CheckTypeRestrictions(JsonValue const &/*json*/,
-                                    ValidationContext &/*context*/) const {
+	// Values without type of their kind have no kind specific restrictions.
+	EnableCheck(kTypeRestrictionsCheck, false);
 }
 
-void JsonAny::CheckEnumsRestrictions(JsonValue const &/*json*/,
-                                     ValidationContext &/*context*/) const {
+void JsonAny::Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const {
+	JsonType::Lower(builder, node);
+	node.op = SchemaProgram::kAnyOp;
+
+	SchemaProgram::AnyRestrictions any = SchemaProgram::AnyRestrictions();
+	any.disallow = disallow_.empty() ? SchemaProgram::kNone : builder.AddNodes(disallow_);
+	any.has_enum = has_enum_;
+	// Order of kinds is order of bits of JsonValueKind.
+	JsonTypePtr const kind_types[] = { null_, boolean_, object_, array_, string_, integer_,
+	                                   number_ };
+	for (size_t kind = 0; kind < sizeof(kind_types) / sizeof(kind_types[0]); ++kind) {
+		any.kind_types[kind] = kind_types[kind] ? builder.AddNode(*kind_types[kind])
+		                                        : SchemaProgram::kNone;
+	}
+	node.restrictions = builder.Add(any);
 }
 
-JsonTypePtr const &JsonAny::GetSchema(JsonValue const &json) const {
-	if (json.IsObject()) return object_;
-	if (json.IsArray())  return array_;
-	if (json.IsString()) return string_;
-	if (json.IsDouble()) return number_;
-	if (json.IsNumber()) return integer_;
-	if (json.IsBool())   return boolean_;
-	return null_;
+void JsonAny::ForEachChild(std::function<void (JsonType const &)> const &function) const {
+	JsonType::ForEachChild(function);
+	for (auto const &disallow : disallow_) {
+		function(*disallow);
+	}
+	for (auto const &type : { string_, number_, integer_, boolean_, object_, array_, null_ }) {
+		if (type) {
+			function(*type);
+		}
+	}
 }
 
-///////////////////////////////////////////////////////////////////////////////////////////////////
 JsonUnionType::JsonUnionType(JsonValue const &schema, JsonResolverPtr const &resolver,
                              std::string const &path)
 	: JsonType(schema, resolver, path)
@@ -118,33 +138,22 @@ JsonUnionType::JsonUnionType(JsonValue const &schema, JsonResolverPtr const &res
 		RaiseError(SchemaErrors::IncorrectUnionType);
 	} else if (type->value.IsArray()) {
 		for (JsonSizeType i = 0; i < type->value.Size(); ++i) {
-			type_.insert(CreateJsonTypeFromArrayElement(schema, type->value[i], resolver, path));
-		}
-	}
-}
-
-void JsonUnionType::Validate(JsonValue const &json, ValidationContext &context) const {
-	for (auto const &type : type_) {
-		ValidationResult type_result;
-		ValidationContext type_context(type_result);
-		type->Validate(json, type_context);
-		if (type_result) {
-			return;
+			type_.push_back(CreateJsonTypeFromArrayElement(schema, type->value[i], resolver, path));
 		}
 	}
-	return RaiseError<NeitherTypeError>(context); // TODO: Specify all child errors.
 }
 
-bool JsonUnionType::CheckValueType(JsonValue const &/*json*/) const {
-	return true;
+void JsonUnionType::Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const {
+	// Union type checks only its types.
+	node.op = SchemaProgram::kUnionOp;
+	node.restrictions = builder.AddNodes(type_);
 }
 
-void JsonUnionType::CheckTypeRestrictions(JsonValue const &/*json*/,
-                                          ValidationContext &/*context*/) const {
-}
-
-void JsonUnionType::CheckEnumsRestrictions(JsonValue const &/*json*/,
-                                           ValidationContext &/*context*/) const {
+void JsonUnionType::ForEachChild(std::function<void (JsonType const &)> const &function) const {
+	JsonType::ForEachChild(function);
+	for (auto const &type : type_) {
+		function(*type);
+	}
 }
 
 } // namespace JsonSchemaValidator
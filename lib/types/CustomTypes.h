@@ -32,33 +32,32 @@ public:
 	JsonCustomType(JsonValue const &schema, JsonResolverPtr const &resolver,
 	               std::string const &path);
 
+	virtual void Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const;
+
 private:
-	virtual bool CheckValueType(JsonValue const &json) const;
-	virtual void CheckTypeRestrictions(JsonValue const &json, ValidationContext &context) const;
-	virtual void CheckEnumsRestrictions(JsonValue const &json, ValidationContext &context) const;
+	virtual void ForEachChild(std::function<void (JsonType const &)> const &function) const;
 
 	JsonTypePtr custom_type_;
 }; // class JsonCustomType : public JsonType
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
+// Type of schema without "type" or with type "any". Values of every kind are checked by type of
+// this kind, which is created only if schema restricts values of the kind. Values of other kinds
+// are checked only by restrictions shared by all kinds ($ref, extends, enum).
 class JsonAny : public JsonType
 {
 public:
 	JsonAny(JsonValue const &schema, JsonResolverPtr const &resolver,
 	        std::string const &path);
 
-	virtual void Validate(JsonValue const &json, ValidationContext &context) const;
+	virtual void Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const;
 
 private:
-	friend class JsonUnionType;
-
-	virtual bool CheckValueType(JsonValue const &json) const;
-	virtual void CheckTypeRestrictions(JsonValue const &json, ValidationContext &context) const;
-	virtual void CheckEnumsRestrictions(JsonValue const &json, ValidationContext &context) const;
-
-	JsonTypePtr const &GetSchema(JsonValue const &json) const;
+	virtual void ForEachChild(std::function<void (JsonType const &)> const &function) const;
 
-	std::set<JsonTypePtr> disallow_;
+	// Types are checked in order of schema.
+	std::vector<JsonTypePtr> disallow_;
+	bool has_enum_;
 
 	JsonTypePtr string_;
 	JsonTypePtr number_;
@@ -76,14 +75,13 @@ public:
 	JsonUnionType(JsonValue const &schema, JsonResolverPtr const &resolver,
 	              std::string const &path);
 
-	virtual void Validate(JsonValue const &json,ValidationContext &context) const;
+	virtual void Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const;
 
 private:
-	virtual bool CheckValueType(JsonValue const &json) const;
-	virtual void CheckTypeRestrictions(JsonValue const &json, ValidationContext &context) const;
-	virtual void CheckEnumsRestrictions(JsonValue const &json, ValidationContext &context) const;
+	virtual void ForEachChild(std::function<void (JsonType const &)> const &function) const;
 
-	std::set<JsonTypePtr> type_;
+	// Types are checked in order of schema.
+	std::vector<JsonTypePtr> type_;
 }; // class JsonUnionType : public JsonType
 
 } // namespace JsonSchemaValidator
@@ -31,13 +31,14 @@ public:
 	JsonTypeImpl(JsonValue const &schema, JsonResolverPtr const &resolver,
 	             std::string const &path);
 
+	virtual void Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const;
+
 protected:
 	typedef Type ValueType;
 
 private:
-	virtual void CheckEnumsRestrictions(JsonValue const &json, ValidationContext &context) const;
-
-	JsonTypeProperty<std::vector<Type>> enum_;
+	// Elements of enum which are values of this type.
+	JsonTypeProperty<JsonValueSet> enum_;
 }; // class JsonTypeImpl : public JsonType
 
 } // namespace JsonSchemaValidator
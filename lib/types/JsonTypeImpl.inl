@@ -14,63 +14,34 @@
 
 #include <JsonSchema.h>
 #include <JsonResolver.h>
-#include <JsonErrors.h>
 
 #include "../Regex.h"
-#include "../ValidationContext.h"
 
 namespace JsonSchemaValidator {
 
-namespace {
-
-template <typename Type>
-struct JsonChecker {
-	static bool ContainsValue(std::vector<Type> const &values, Type const &value) {
-		return std::binary_search(values.begin(), values.end(), value);
-	}
-}; // class JsonChecker
-
-struct JsonCheckerNotOrdered {
-	template <typename Type>
-	static bool ContainsValue(std::vector<Type> const &values, Type const &value) {
-		auto const it = std::find_if(begin(values), end(values), [&value](Type const &elem) {
-			return IsEqual(value.GetValue(), elem.GetValue());
-		});
-		return it != end(values);
-	}
-}; // struct JsonCheckerNotOrdered
-
-template <>
-struct JsonChecker<JsonObjectValue> : public JsonCheckerNotOrdered {
-}; // class JsonChecker<JsonObjectValue>
-
-template <>
-struct JsonChecker<JsonArrayValue> : public JsonCheckerNotOrdered {
-}; // class JsonChecker<JsonArrayValue>
-
-template <>
-struct JsonChecker<JsonNullValue> : public JsonCheckerNotOrdered {
-}; // class JsonChecker<JsonNullValue>
-
-} // namespace
-
 template <typename Type>
 JsonTypeImpl<Type>::JsonTypeImpl(JsonValue const &schema, JsonResolverPtr const &resolver,
                                  std::string const &path)
 	: JsonType(schema, resolver, path)
 	, enum_() {
 
-	GetChildValue(schema, "enum", enum_);
+	JsonValueMember const *enum_values = FindMember(schema, "enum");
+	if (enum_values && enum_values->value.IsArray()) {
+		enum_.exists = true;
+		for (JsonSizeType i = 0; i < enum_values->value.Size(); ++i) {
+			Type value;
+			if (GetValue(enum_values->value[i], value)) {
+				enum_.value.Insert(enum_values->value[i]);
+			}
+		}
+	}
 }
 
 template <typename Type>
-void JsonTypeImpl<Type>::CheckEnumsRestrictions(JsonValue const &json,
-                                                ValidationContext &context) const {
+void JsonTypeImpl<Type>::Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const {
+	JsonType::Lower(builder, node);
 	if (enum_.exists) {
-		Type value = GetValue<Type>(json);
-		if (!JsonChecker<Type>::ContainsValue(enum_.value, value)) {
-			return RaiseError<EnumValueError>(context);
-		}
+		node.enum_values = builder.AddEnum(enum_.value);
 	}
 }
 
@@ -14,11 +14,13 @@
 
 #include "PrimitiveTypes.h"
 
+#include <vector>
+#include <algorithm>
+
 #include <JsonSchema.h>
 #include <JsonResolver.h>
 
 #include "../Regex.h"
-#include "../ValidationContext.h"
 
 namespace JsonSchemaValidator {
 
@@ -36,22 +38,21 @@ JsonString::JsonString(JsonValue const &schema, JsonResolverPtr const &resolver,
 	if (GetChildValue(schema, "pattern", pattern)) {
 		pattern_ = Regex::Create(pattern);
 	}
-}
 
-bool JsonString::CheckValueType(JsonValue const &json) const {
-	return json.IsString();
+	SetValueKinds(kStringKind);
+	EnableCheck(kTypeRestrictionsCheck, min_length_ > 0 ||
+	            max_length_ < std::numeric_limits<size_t>::max() || pattern_);
 }
 
-void JsonString::CheckTypeRestrictions(JsonValue const &json, ValidationContext &context) const {
-	if (json.GetStringLength() < min_length_) {
-		return RaiseError<MinimalLengthError>(context, min_length_);
-	}
-	if (json.GetStringLength() > max_length_) {
-		return RaiseError<MaximalLengthError>(context, max_length_);
-	}
-
-	if (pattern_ && !pattern_->IsCorrespond(GetValue<char const *>(json))) {
-		return RaiseError<PatternError>(context, pattern_->Pattern());
+void JsonString::Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const {
+	JsonTypeImpl::Lower(builder, node);
+	node.op = SchemaProgram::kStringOp;
+	if (IsCheckEnabled(kTypeRestrictionsCheck)) {
+		SchemaProgram::StringRestrictions string = SchemaProgram::StringRestrictions();
+		string.min_length = min_length_;
+		string.max_length = max_length_;
+		string.pattern = pattern_ ? builder.AddRegex(pattern_) : SchemaProgram::kNone;
+		node.restrictions = builder.Add(string);
 	}
 }
 
@@ -73,6 +74,11 @@ JsonBaseNumber<Type>::JsonBaseNumber(JsonValue const &schema, JsonResolverPtr co
 	GetChildValue(schema, "exclusiveMaximum", exclusive_maximum_);
 
 	GetChildValue(schema, "divisibleBy", divisible_by_);
+
+	this->EnableCheck(Parent::kTypeRestrictionsCheck,
+	                  minimum_ != std::numeric_limits<typename Parent::ValueType>::lowest() ||
+	                  maximum_ != std::numeric_limits<typename Parent::ValueType>::max() ||
+	                  exclusive_minimum_ || exclusive_maximum_ || divisible_by_.exists);
 }
 
 template <>
@@ -89,48 +95,44 @@ bool JsonBaseNumber<double>::IsEqual(double left, double right) {
 JsonNumber::JsonNumber(JsonValue const &schema, JsonResolverPtr const &resolver,
                        std::string const &path)
 	: JsonBaseNumber(schema, resolver, path) {
-}
 
-bool JsonNumber::CheckValueType(JsonValue const &json) const {
-	return json.IsNumber();
+	SetValueKinds(kNumberKind);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 JsonInteger::JsonInteger(JsonValue const &schema, JsonResolverPtr const &resolver,
                          std::string const &path)
 	: JsonBaseNumber(schema, resolver, path) {
-}
 
-bool JsonInteger::CheckValueType(JsonValue const &json) const {
-	return json.IsInt64() || json.IsUint64() || json.IsInt() || json.IsUint();
+	SetValueKinds(kIntegerKind);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 JsonBoolean::JsonBoolean(JsonValue const &schema, JsonResolverPtr const &resolver,
                          std::string const &path)
 	: JsonTypeImpl(schema, resolver, path) {
-}
 
-bool JsonBoolean::CheckValueType(JsonValue const &json) const {
-	return json.IsBool();
+	SetValueKinds(kBooleanKind);
+	EnableCheck(kTypeRestrictionsCheck, false);
 }
 
-void JsonBoolean::CheckTypeRestrictions(JsonValue const &/*json*/,
-	                                    ValidationContext &/*context*/) const {
+void JsonBoolean::Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const {
+	JsonTypeImpl::Lower(builder, node);
+	node.op = SchemaProgram::kBooleanOp;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 JsonNull::JsonNull(JsonValue const &schema, JsonResolverPtr const &resolver,
                    std::string const &path)
 	: JsonTypeImpl(schema, resolver, path) {
-}
 
-bool JsonNull::CheckValueType(JsonValue const &json) const {
-	return json.IsNull();
+	SetValueKinds(kNullKind);
+	EnableCheck(kTypeRestrictionsCheck, false);
 }
 
-void JsonNull::CheckTypeRestrictions(JsonValue const &/*json*/,
-                                     ValidationContext &/*context*/) const {
+void JsonNull::Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const {
+	JsonTypeImpl::Lower(builder, node);
+	node.op = SchemaProgram::kNullOp;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -138,20 +140,44 @@ JsonObject::JsonObject(JsonValue const &schema, JsonResolverPtr const &resolver,
                        std::string const &path)
 	: JsonTypeImpl(schema, resolver, path)
 	, properties_()
+	, names_()
+	, required_properties_()
 	, pattern_properties_()
+	, patterns_()
 	, may_contains_additional_properties_()
 	, additional_properties_()
 	, simple_dependencies_()
+	, simple_dependency_indexes_()
 	, schema_dependencies_() {
 
+	std::map<char const *, JsonTypePtr, StrLess> properties;
 	for (auto const &member : GetMembers(schema, "properties")) {
-		properties_.insert({ GetValue<char const *>(member.name),
-		                     CreateMember(member, resolver) });
+		properties.insert({ GetValue<char const *>(member.name), CreateMember(member, resolver) });
+	}
+	std::vector<char const *> names;
+	std::map<char const *, size_t, StrLess> name_indexes;
+	auto name_index = [&names, &name_indexes](char const *name) -> size_t {
+		auto inserted = name_indexes.insert({ name, names.size() });
+		if (inserted.second) {
+			names.push_back(name);
+		}
+		return inserted.first->second;
+	};
+	for (auto const &property : properties) {
+		properties_.push_back(property);
+		size_t index = name_index(property.first);
+		if (property.second->IsRequired()) {
+			NameSet::AddToMask(required_properties_, index);
+		}
 	}
 
+	std::vector<char const *> patterns;
 	for (auto const &member : GetMembers(schema, "patternProperties")) {
-		pattern_properties_.push_back({ Regex::Create(GetValue<char const *>(member.name)),
-		                                CreateMember(member, resolver) });
+		patterns.push_back(GetValue<char const *>(member.name));
+		pattern_properties_.push_back(CreateMember(member, resolver));
+	}
+	if (!patterns.empty()) {
+		patterns_ = RegexSet::Create(patterns);
 	}
 
 	GetChildValue(schema, "additionalProperties", may_contains_additional_properties_);
@@ -159,6 +185,7 @@ JsonObject::JsonObject(JsonValue const &schema, JsonResolverPtr const &resolver,
 		GetChildValue(schema, "additionalProperties", additional_properties_, resolver, path);
 	}
 
+	std::map<char const *, std::set<char const *, StrLess>, StrLess> simple_dependencies;
 	for (auto const &member : GetMembers(schema, "dependencies")) {
 		if (member.value.IsObject()) {
 			schema_dependencies_.insert({ GetValue<char const *>(member.name),
@@ -172,78 +199,120 @@ JsonObject::JsonObject(JsonValue const &schema, JsonResolverPtr const &resolver,
 					throw IncorrectSchema(SchemaErrors::IncorrectDependencies);
 				}
 			}
-			simple_dependencies_.insert({ GetValue<char const *>(member.name), strings });
+			simple_dependencies.insert({ GetValue<char const *>(member.name), strings });
 		}
 		else if (member.value.IsString()) {
-			simple_dependencies_.insert({ GetValue<char const *>(member.name),
-			                            { GetValue<char const *>(member.value) } });
+			simple_dependencies.insert({ GetValue<char const *>(member.name),
+			                           { GetValue<char const *>(member.value) } });
 		}
 		else {
 			throw IncorrectSchema(SchemaErrors::IncorrectDependencies);
 		}
 	}
+	for (auto const &dependency : simple_dependencies) {
+		SimpleDependency simple_dependency{ dependency.first, name_index(dependency.first), {} };
+		for (char const *name : dependency.second) {
+			NameSet::AddToMask(simple_dependency.dependencies, name_index(name));
+		}
+		simple_dependencies_.push_back(simple_dependency);
+	}
+	names_ = NameTable(names);
+	simple_dependency_indexes_.resize(names.size(), NameTable::kNotFound);
+	for (size_t i = 0; i < simple_dependencies_.size(); ++i) {
+		simple_dependency_indexes_[simple_dependencies_[i].index] = i;
+	}
+
+	SetValueKinds(kObjectKind);
+	EnableCheck(kTypeRestrictionsCheck, !properties_.empty() || !pattern_properties_.empty() ||
+	            may_contains_additional_properties_.exists || additional_properties_.exists ||
+	            !simple_dependencies_.empty() || !schema_dependencies_.empty());
 }
 
-bool JsonObject::CheckValueType(JsonValue const &json) const {
-	return json.IsObject();
+void JsonObject::ForEachChild(std::function<void (JsonType const &)> const &function) const {
+	JsonType::ForEachChild(function);
+	for (auto const &property : properties_) {
+		function(*property.second);
+	}
+	for (auto const &pattern_property : pattern_properties_) {
+		function(*pattern_property);
+	}
+	if (additional_properties_.exists) {
+		function(*additional_properties_.value);
+	}
+	for (auto const &dependency : schema_dependencies_) {
+		function(*dependency.second);
+	}
 }
 
-void JsonObject::CheckTypeRestrictions(JsonValue const &json, ValidationContext &context) const {
-	for (auto const &member : GetMembers(json)) {
-		bool described_property = false;
-		char const *name = GetValue<char const *>(member.name);
-		MemberPathHolder path_holder(name, context);
-		auto propertyIt = properties_.find(name);
-		if (propertyIt != properties_.end()) {
-			propertyIt->second->Validate(member.value, context);
-			if (!context.GetResult()) return;
-			described_property = true;
-		}
-		for (auto const &pattern_property : pattern_properties_) {
-			if (pattern_property.first->IsCorrespond(name)) {
-				pattern_property.second->Validate(member.value, context);
-				if (!context.GetResult()) return;
-				described_property = true;
-			}
-		}
+void JsonObject::Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const {
+	JsonTypeImpl::Lower(builder, node);
+	node.op = SchemaProgram::kObjectOp;
+	if (!IsCheckEnabled(kTypeRestrictionsCheck)) {
+		return;
+	}
 
-		if (!described_property) {
-			if (may_contains_additional_properties_.exists) {
-				if (!may_contains_additional_properties_.value) {
-					path_holder.Reset();
-					return RaiseError<AdditionalPropertyError>(context, name);
-				}
-			}
-			else if (additional_properties_.exists) {
-				additional_properties_.value->Validate(member.value, context);
-				if (!context.GetResult()) return;
-			}
+	SchemaProgram::ObjectRestrictions object = SchemaProgram::ObjectRestrictions();
+	object.names = builder.AddNameTable(names_);
+	std::vector<uint32_t> properties;
+	for (auto const &property : properties_) {
+		properties.push_back(builder.AddNode(*property.second));
+	}
+	object.properties = builder.AddList(properties);
+	object.required = builder.AddMask(required_properties_);
+
+	object.patterns = SchemaProgram::kNone;
+	object.pattern_properties = SchemaProgram::kNone;
+	if (patterns_) {
+		object.patterns = builder.AddRegexSet(patterns_);
+		object.pattern_properties = builder.AddNodes(pattern_properties_);
+	}
+
+	object.additional = SchemaProgram::kAllowAdditional;
+	object.additional_properties = SchemaProgram::kNone;
+	if (may_contains_additional_properties_.exists) {
+		if (!may_contains_additional_properties_.value) {
+			object.additional = SchemaProgram::kForbidAdditional;
 		}
+	}
+	else if (additional_properties_.exists) {
+		object.additional = SchemaProgram::kValidateAdditional;
+		object.additional_properties = builder.AddNode(*additional_properties_.value);
+	}
 
-		if (!simple_dependencies_.empty()) {
-			auto simpleArrayDependIt = simple_dependencies_.find(name);
-			if (simpleArrayDependIt != simple_dependencies_.end()) {
-				for (auto const &depend : simpleArrayDependIt->second) {
-					if (!json.HasMember(depend)) {
-						return RaiseError<DependenciesRestrictionsError>(context, name);
-					}
-				}
+	object.simple_dependencies = SchemaProgram::kNone;
+	object.simple_dependencies_count = static_cast<uint32_t>(simple_dependencies_.size());
+	object.dependency_indexes = SchemaProgram::kNone;
+	if (!simple_dependencies_.empty()) {
+		for (auto const &dependency : simple_dependencies_) {
+			SchemaProgram::SimpleDependency simple_dependency{
+				builder.AddString(dependency.name), static_cast<uint32_t>(dependency.index),
+				builder.AddMask(dependency.dependencies) };
+			uint32_t added = builder.Add(simple_dependency);
+			if (object.simple_dependencies == SchemaProgram::kNone) {
+				object.simple_dependencies = added;
 			}
 		}
-		if (!schema_dependencies_.empty()) {
-			auto schemaDependIt = schema_dependencies_.find(name);
-			if (schemaDependIt != schema_dependencies_.end()) {
-				schemaDependIt->second->Validate(json, context);
-				if (!context.GetResult()) return;
-			}
+		std::vector<uint32_t> dependency_indexes;
+		for (size_t index : simple_dependency_indexes_) {
+			dependency_indexes.push_back(index == NameTable::kNotFound ? SchemaProgram::kNone
+			                             : static_cast<uint32_t>(index));
 		}
-		path_holder.Reset();
+		object.dependency_indexes = builder.AddList(dependency_indexes);
 	}
-	for (auto const &property : properties_) {
-		if (property.second->IsRequired() && !json.HasMember(property.first)) {
-			return RaiseError<RequiredPropertyError>(context, property.first);
+
+	object.schema_dependency_names = SchemaProgram::kNone;
+	object.schema_dependencies = SchemaProgram::kNone;
+	if (!schema_dependencies_.empty()) {
+		std::vector<char const *> names;
+		std::vector<uint32_t> dependencies;
+		for (auto const &dependency : schema_dependencies_) {
+			names.push_back(dependency.first);
+			dependencies.push_back(builder.AddNode(*dependency.second));
 		}
+		object.schema_dependency_names = builder.AddNameTable(NameTable(names));
+		object.schema_dependencies = builder.AddList(dependencies);
 	}
+	node.restrictions = builder.Add(object);
 }
 
 JsonTypePtr JsonObject::CreateMember(JsonValueMember const &member,
@@ -276,62 +345,52 @@ JsonArray::JsonArray(JsonValue const &schema, JsonResolverPtr const &resolver,
 	if (!may_contains_additional_items_.exists) {
 		GetChildValue(schema, "additionalItems", additional_items_, resolver, path);
 	}
-}
 
-bool JsonArray::CheckValueType(JsonValue const &json) const {
-	return json.IsArray();
+	SetValueKinds(kArrayKind);
+	EnableCheck(kTypeRestrictionsCheck, min_items_ > 0 ||
+	            max_items_ < std::numeric_limits<size_t>::max() || unique_items_ ||
+	            items_.exists || items_array_.exists);
 }
 
-void JsonArray::CheckTypeRestrictions(JsonValue const &json, ValidationContext &context) const {
-	if (json.Size() < min_items_) {
-		return RaiseError<MinimalItemsCountError>(context, min_items_);
+void JsonArray::ForEachChild(std::function<void (JsonType const &)> const &function) const {
+	JsonType::ForEachChild(function);
+	if (items_.exists) {
+		function(*items_.value);
+	}
+	for (auto const &item : items_array_.value) {
+		function(*item);
 	}
-	if (json.Size() > max_items_) {
-		return RaiseError<MaximalItemsCountError>(context, max_items_);
+	if (additional_items_.exists) {
+		function(*additional_items_.value);
 	}
+}
 
-	if (unique_items_ && !json.Empty()) {
-		for (rapidjson::SizeType i = 0; i < json.Size() - 1; ++i) {
-			for (rapidjson::SizeType j = i + 1; j < json.Size(); ++j) {
-				if (IsEqual(json[i], json[j])) {
-					return RaiseError<UniqueItemsError>(context);
-				}
-			}
-		}
+void JsonArray::Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const {
+	JsonTypeImpl::Lower(builder, node);
+	node.op = SchemaProgram::kArrayOp;
+	if (!IsCheckEnabled(kTypeRestrictionsCheck)) {
+		return;
 	}
 
-	if (items_.exists) {
-		for (rapidjson::SizeType i = 0; i < json.Size(); ++i) {
-			ElementPathHolder path_holder(i, context);
-			items_.value->Validate(json[i], context);
-			if (!context.GetResult()) return;
-			path_holder.Reset();
+	SchemaProgram::ArrayRestrictions array = SchemaProgram::ArrayRestrictions();
+	array.min_items = min_items_;
+	array.max_items = max_items_;
+	array.unique_items = unique_items_;
+	array.items = items_.exists ? builder.AddNode(*items_.value) : SchemaProgram::kNone;
+	array.items_list = items_array_.exists ? builder.AddNodes(items_array_.value)
+	                                       : SchemaProgram::kNone;
+	array.additional = SchemaProgram::kAllowAdditional;
+	array.additional_items = SchemaProgram::kNone;
+	if (may_contains_additional_items_.exists) {
+		if (!may_contains_additional_items_.value) {
+			array.additional = SchemaProgram::kForbidAdditional;
 		}
 	}
-	else if (items_array_.exists) {
-		rapidjson::SizeType i = 0;
-		for (; i < json.Size() && i < items_array_.value.size(); ++i) {
-			ElementPathHolder path_holder(i, context);
-			items_array_.value[i]->Validate(json[i], context);
-			if (!context.GetResult()) return;
-			path_holder.Reset();
-		}
-		if (i < json.Size()) {
-			if (may_contains_additional_items_.exists) {
-				if (!may_contains_additional_items_.value) {
-					return RaiseError<AdditionalItemsError>(context);
-				}
-			}
-			else if (additional_items_.exists) {
-				for (; i < json.Size(); ++i) {
-					ElementPathHolder path_holder(i, context);
-					additional_items_.value->Validate(json[i], context);
-					if (!context.GetResult()) return;
-					path_holder.Reset();
-				}
-			}
-		}
+	else if (additional_items_.exists) {
+		array.additional = SchemaProgram::kValidateAdditional;
+		array.additional_items = builder.AddNode(*additional_items_.value);
 	}
+	node.restrictions = builder.Add(array);
 }
 
 } // namespace JsonSchemaValidator
@@ -21,6 +21,7 @@
 #include <utility>
 #include <regex>
 
+#include "../NameTable.h"
 #include "JsonTypeImpl.h"
 
 namespace JsonSchemaValidator {
@@ -30,10 +31,9 @@ public:
 	JsonString(JsonValue const &schema, JsonResolverPtr const &resolver,
 	           std::string const &path);
 
-private:
-	virtual bool CheckValueType(JsonValue const &json) const;
-	virtual void CheckTypeRestrictions(JsonValue const &json, ValidationContext &context) const;
+	virtual void Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const;
 
+private:
 	size_t min_length_;
 	size_t max_length_;
 
@@ -50,14 +50,13 @@ public:
 	JsonBaseNumber(JsonValue const &schema, JsonResolverPtr const &resolver,
 	               std::string const &path);
 
-private:
-	typedef double DividerType;
-
-	virtual void CheckTypeRestrictions(JsonValue const &json, ValidationContext &context) const;
+	virtual void Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const;
 
+	// Comparisons of values with limits, they are shared with SchemaProgram.
 	static bool IsEqual(Type left, Type right);
-	static bool CheckDivisibility(Type value, DividerType divider);
+	static bool CheckDivisibility(Type value, double divider);
 
+private:
 	typename Parent::ValueType minimum_;
 	typename Parent::ValueType maximum_;
 
@@ -72,9 +71,6 @@ class JsonNumber : public JsonBaseNumber<double> {
 public:
 	JsonNumber(JsonValue const &schema, JsonResolverPtr const &resolver,
 	           std::string const &path);
-
-private:
-	virtual bool CheckValueType(JsonValue const &json) const;
 }; // class JsonNumber : public JsonBaseNumber<double>
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -82,9 +78,6 @@ class JsonInteger : public JsonBaseNumber<long long> {
 public:
 	JsonInteger(JsonValue const &schema, JsonResolverPtr const &resolver,
 	            std::string const &path);
-
-private:
-	virtual bool CheckValueType(JsonValue const &json) const;
 }; // class JsonInteger : public JsonBaseNumber<long long>
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -93,9 +86,7 @@ public:
 	JsonBoolean(JsonValue const &schema, JsonResolverPtr const &resolver,
 	            std::string const &path);
 
-private:
-	virtual bool CheckValueType(JsonValue const &json) const;
-	virtual void CheckTypeRestrictions(JsonValue const &json, ValidationContext &context) const;
+	virtual void Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const;
 }; // class JsonBoolean : public JsonTypeImpl<bool>
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -104,9 +95,7 @@ public:
 	JsonNull(JsonValue const &schema, JsonResolverPtr const &resolver,
 	         std::string const &path);
 
-private:
-	virtual bool CheckValueType(JsonValue const &json) const;
-	virtual void CheckTypeRestrictions(JsonValue const &json, ValidationContext &context) const;
+	virtual void Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const;
 }; // class JsonNull : public JsonTypeImpl<JsonNullValue>
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -115,20 +104,35 @@ public:
 	JsonObject(JsonValue const &schema, JsonResolverPtr const &resolver,
 	           std::string const &path);
 
+	virtual void Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const;
+
 private:
-	virtual bool CheckValueType(JsonValue const &json) const;
-	virtual void CheckTypeRestrictions(JsonValue const &json, ValidationContext &context) const;
+	virtual void ForEachChild(std::function<void (JsonType const &)> const &function) const;
 
 	JsonTypePtr CreateMember(JsonValueMember const &member, JsonResolverPtr const &resolver) const;
 
-	std::map<char const *, JsonTypePtr, StrLess> properties_;
+	struct SimpleDependency {
+		char const *name;
+		size_t index;
+		NameSet::Mask dependencies;
+	}; // struct SimpleDependency
+
+	// Properties are sorted by name. Table contains names of properties and then other names of
+	// simple dependencies, so index of property name is index of property.
+	std::vector<std::pair<char const *, JsonTypePtr>> properties_;
+	NameTable names_;
+	NameSet::Mask required_properties_;
 
-	std::vector<std::pair<RegexPtr, JsonTypePtr>> pattern_properties_;
+	// Patterns of all pattern properties are searched in name of member at once.
+	std::vector<JsonTypePtr> pattern_properties_;
+	RegexSetPtr patterns_;
 
 	JsonTypeProperty<bool> may_contains_additional_properties_;
 	JsonTypeProperty<JsonTypePtr> additional_properties_;
 
-	std::map<char const *, std::set<char const *, StrLess>, StrLess> simple_dependencies_;
+	std::vector<SimpleDependency> simple_dependencies_;
+	// Index of simple dependency by index of name or NameTable::kNotFound.
+	std::vector<size_t> simple_dependency_indexes_;
 	std::map<char const *, JsonTypePtr, StrLess> schema_dependencies_;
 }; // class JsonObject : public JsonTypeImpl<JsonObjectValue>
 
@@ -138,9 +142,10 @@ public:
 	JsonArray(JsonValue const &schema, JsonResolverPtr const &resolver,
 	          std::string const &path);
 
+	virtual void Lower(SchemaProgram::Builder &builder, SchemaProgram::Node &node) const;
+
 private:
-	virtual bool CheckValueType(JsonValue const &json) const;
-	virtual void CheckTypeRestrictions(JsonValue const &json, ValidationContext &context) const;
+	virtual void ForEachChild(std::function<void (JsonType const &)> const &function) const;
 
 	size_t min_items_;
 	size_t max_items_;
@@ -14,34 +14,35 @@
 
 #include "PrimitiveTypes.h"
 
-#include <JsonErrors.h>
+#include <type_traits>
 
-#include "../ValidationContext.h"
+#include <cmath>
+#include <limits>
 
 namespace JsonSchemaValidator {
 
 template <typename Type>
-bool JsonBaseNumber<Type>::CheckDivisibility(Type value, DividerType divider) {
+bool JsonBaseNumber<Type>::CheckDivisibility(Type value, double divider) {
 	double division = static_cast<double>(value) / static_cast<double>(divider);
 	double round_division = static_cast<double>(static_cast<long long>(division + 0.5));
 	return std::fabs(division - round_division) <= std::numeric_limits<Type>::epsilon();
 }
 
 template <typename Type>
-void JsonBaseNumber<Type>::CheckTypeRestrictions(JsonValue const &json,
-                                                 ValidationContext &context) const {
-	typename Parent::ValueType value = GetValue<typename Parent::ValueType>(json);
-	if ((value < minimum_) || (exclusive_minimum_ && IsEqual(value,  minimum_))) {
-		return this->template RaiseError<MinimumValueError<Type> >(context, minimum_,
-		                                                           exclusive_minimum_);
-	}
-	if ((maximum_ < value) || (exclusive_maximum_ && IsEqual(maximum_, value))) {
-		return this->template RaiseError<MaximumValueError<Type> >(context, maximum_,
-		                                                           exclusive_maximum_);
-	}
-
-	if (divisible_by_.exists && !CheckDivisibility(value, divisible_by_.value)) {
-		return this->template RaiseError<DivisibleValueError>(context, divisible_by_.value);
+void JsonBaseNumber<Type>::Lower(SchemaProgram::Builder &builder,
+                                 SchemaProgram::Node &node) const {
+	Parent::Lower(builder, node);
+	node.op = std::is_same<Type, double>::value ? SchemaProgram::kNumberOp
+	                                            : SchemaProgram::kIntegerOp;
+	if (this->IsCheckEnabled(Parent::kTypeRestrictionsCheck)) {
+		SchemaProgram::NumberRestrictions<Type> number = SchemaProgram::NumberRestrictions<Type>();
+		number.minimum = minimum_;
+		number.maximum = maximum_;
+		number.divisible_by = divisible_by_.value;
+		number.exclusive_minimum = exclusive_minimum_;
+		number.exclusive_maximum = exclusive_maximum_;
+		number.has_divisible_by = divisible_by_.exists;
+		node.restrictions = builder.Add(number);
 	}
 }
 
@@ -37,16 +37,29 @@ double TestValidator(ValidatorPtr const &validator, Test const &test) {
 	return static_cast<double>(timer.elapsed().wall) / tests_count;
 }
 
+double TestIsValid(std::shared_ptr<RJValidator> const &validator, Test const &test) {
+	static int const tests_count = 10000;
+
+	validator->Load(test.GetInspectedDocument());
+
+	boost::timer::cpu_timer timer;
+	for (int i = 0; i < tests_count; ++i) {
+		validator->IsValid();
+	}
+	return static_cast<double>(timer.elapsed().wall) / tests_count;
+}
+
 int main(int /*argc*/, char * /*argv*/[]) {
 	std::stringstream report_stream;
-	double sum_rjtime = 0, sum_wjtime = 0;
+	double sum_rjtime = 0, sum_wjtime = 0, sum_rjvalidtime = 0;
 	for (auto const &test : ::Test::GetTests()) {
 		std::cout << test.GetName() << std::endl;
-		ValidatorPtr rjvalidator = std::make_shared<RJValidator>(test.GetSchema());
+		auto rjvalidator = std::make_shared<RJValidator>(test.GetSchema());
 		ValidatorPtr wjvalidator = std::make_shared<WJValidator>(test.GetSchema());
 
 		double rjtime = TestValidator(rjvalidator, test);
 		double wjtime = TestValidator(wjvalidator, test);
+		double rjvalidtime = TestIsValid(rjvalidator, test);
 
 		if (wjtime / rjtime < 20) {
 			report_stream << test.GetName() << ": " << rjtime << "   " << wjtime << std::endl;
@@ -54,8 +67,11 @@ int main(int /*argc*/, char * /*argv*/[]) {
 
 		sum_rjtime += rjtime;
 		sum_wjtime += wjtime;
+		sum_rjvalidtime += rjvalidtime;
 	}
 	std::cout << std::endl << report_stream.str() << std::endl;
 	std::cout << "SUM: " << " " << sum_rjtime << "   " << sum_wjtime << std::endl;
 	std::cout << sum_wjtime / sum_rjtime << std::endl;
+	std::cout << "IsValid: " << sum_rjvalidtime << "   " << sum_rjtime / sum_rjvalidtime
+	          << std::endl;
 }
@@ -0,0 +1,356 @@
+// Copyright 2016 lyobzik
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include <gtest/gtest.h>
+
+#include <JsonSchema.h>
+#include <JsonErrors.h>
+#include <JsonDefs.h>
+#include <JsonResolver.h>
+
+#include <BinarySchema.h>
+#include <CheckedSchemas.h>
+#include <JsonType.h>
+#include <NameTable.h>
+#include <SchemaProgram.h>
+#include <ValidationContext.h>
+
+#include <Test.h>
+
+using namespace TestsCommon;
+using namespace JsonSchemaValidator;
+
+// Checks of library classes which are not part of public interface.
+class InternalTests : public ::testing::Test
+{
+}; // class InternalTests : public ::testing::Test
+
+namespace {
+
+// Resolver which doesn't know any external schema.
+class NullResolver : public JsonResolver {
+public:
+	virtual JsonSchemaPtr Resolve(std::string const &) const {
+		return JsonSchemaPtr();
+	}
+}; // class NullResolver
+
+} // namespace
+
+TEST_F(InternalTests, SharedTypesTests) {
+	JsonDocument properties;
+	properties.Parse(R"({"a": {"type": "string", "pattern": "^x"},)"
+	                 R"( "b": {"pattern": "^x", "type": "string"},)"
+	                 R"( "c": {"type": "string", "pattern": "^y"},)"
+	                 R"( "d": {"type": "integer", "maximum": 1},)"
+	                 R"( "e": {"type": "integer", "maximum": 1.0},)"
+	                 R"( "f": {"items": [{"maximum": 1}, {"minimum": 1}]},)"
+	                 R"( "g": {"items": [{"minimum": 1}, {"maximum": 1}]}})");
+	std::map<std::string, JsonTypePtr> types;
+	{
+		SharedTypes shared_types;
+		for (auto member = properties.MemberBegin(); member != properties.MemberEnd(); ++member) {
+			types[member->name.GetString()] = JsonType::Create(member->value, JsonResolverPtr(),
+			                                                   "/");
+		}
+	}
+	// Members are compared independently of order, numbers and items are compared strictly.
+	ASSERT_EQ(types["a"], types["b"]);
+	ASSERT_NE(types["a"], types["c"]);
+	ASSERT_NE(types["d"], types["e"]);
+	ASSERT_NE(types["f"], types["g"]);
+
+	// Types are shared only while SharedTypes exists.
+	ASSERT_NE(types["a"], JsonType::Create(properties["b"], JsonResolverPtr(), "/"));
+}
+
+TEST_F(InternalTests, NameTableTests) {
+	ASSERT_EQ(NameTable::kNotFound, NameTable().Find("a", 1));
+	ASSERT_EQ(NameTable::kNotFound, NameTable(std::vector<char const *>()).Find("", 0));
+
+	// Names are prefixes of each other, differ only by last byte or are empty.
+	std::vector<std::string> strings = {"", "a", "aa", "aaa", "ab", "ba", "b"};
+	for (int i = 0; i < 10000; ++i) {
+		strings.push_back("p" + std::to_string(i));
+		strings.push_back("q" + std::to_string(i) + std::string(i % 7, 'x'));
+	}
+	std::vector<char const *> names;
+	for (auto const &string : strings) {
+		names.push_back(string.c_str());
+	}
+	NameTable table(names);
+	ASSERT_EQ(names.size(), table.Size());
+	for (size_t i = 0; i < strings.size(); ++i) {
+		ASSERT_EQ(i, table.Find(strings[i].data(), strings[i].size())) << strings[i];
+	}
+	std::vector<std::string> const missing_names = {"aaaa", "c", "p10000", "q1", "p1x",
+	                                                 std::string("a\0", 2)};
+	for (auto const &missing : missing_names) {
+		ASSERT_EQ(NameTable::kNotFound, table.Find(missing.data(), missing.size())) << missing;
+	}
+	// Names are compared by length, so prefix of table name isn't found.
+	ASSERT_EQ(NameTable::kNotFound, table.Find("q1234xx", 6));
+
+	// Set is moved from heap to inline words and back.
+	NameSet set(strings.size());
+	NameSet::Mask mask;
+	for (size_t index : {0, 63, 64, 5000, 20006}) {
+		NameSet::AddToMask(mask, index);
+		set.Insert(index);
+	}
+	ASSERT_EQ(NameTable::kNotFound, set.FindMissing(mask));
+	NameSet::AddToMask(mask, 12345);
+	ASSERT_EQ(12345u, set.FindMissing(mask));
+	set.Reset(10);
+	ASSERT_FALSE(set.Contains(0));
+	ASSERT_EQ(0u, set.FindMissing(NameSet::Mask{1}));
+	set.Reset(strings.size());
+	ASSERT_FALSE(set.Contains(20006));
+}
+
+TEST_F(InternalTests, BinaryTests) {
+	char const *const schema_data =
+		R"({"type": "object", "properties": {)"
+		R"("a": {"type": "string", "pattern": "^x", "required": true},)"
+		R"( "b": {"enum": [null, true, -1, 18446744073709551615, 0.5, [], {}]}},)"
+		R"( "title": "\u0000"})";
+	std::string image;
+	JsonSchema(schema_data).Save(image);
+	JsonDocument document;
+	BinarySchema::Wrap(image.data(), image.size())->Read(document);
+	JsonDocument expected_document;
+	expected_document.Parse(schema_data);
+	ASSERT_TRUE(document == expected_document);
+
+	// Truncated or corrupted image is rejected or read as other document, but it's never read
+	// out of its bounds.
+	for (size_t size = 0; size < image.size(); ++size) {
+		ASSERT_THROW(BinarySchema::Wrap(image.data(), size), IncorrectSchema) << size;
+	}
+	size_t rejected_count = 0;
+	for (size_t i = 0; i < image.size(); ++i) {
+		std::string corrupted = image;
+		corrupted[i] ^= 0x5a;
+		try {
+			BinarySchema::Wrap(corrupted.data(), corrupted.size())->Read(document);
+		}
+		catch (IncorrectSchema const &) {
+			++rejected_count;
+			continue;
+		}
+		// Other document is correct, so it's written and read again without changes.
+		std::string written;
+		std::string rewritten;
+		JsonDocument read_document;
+		BinarySchema::Write(document, written);
+		BinarySchema::Wrap(written.data(), written.size())->Read(read_document);
+		BinarySchema::Write(read_document, rewritten);
+		ASSERT_EQ(written, rewritten) << i;
+	}
+	ASSERT_LT(0u, rejected_count);
+
+	// Records are written after header of 48 bytes and have 16 bytes (kind, size and payload).
+	// Containers of [[0, 0], [0, 0]] refer to children 1, 3 and 5, so if the second inner array
+	// refers to children of the first one, the records become a graph instead of a tree.
+	std::string array_image;
+	BinarySchema::Write(expected_document.Parse("[[0, 0], [0, 0]]"), array_image);
+	BinarySchema::Wrap(array_image.data(), array_image.size())->Read(document);
+	ASSERT_TRUE(document == expected_document);
+	uint64_t const shared_child = 3;
+	std::memcpy(&array_image[48 + 2 * 16 + 8], &shared_child, sizeof(shared_child));
+	ASSERT_THROW(BinarySchema::Wrap(array_image.data(), array_image.size()), IncorrectSchema);
+}
+
+TEST_F(InternalTests, BinaryProgramTests) {
+	char const *const schema_data =
+		R"({"type": "object", "properties": {)"
+		R"("a": {"type": "string", "pattern": "^x", "required": true},)"
+		R"( "b": {"enum": [1, "b"]}, "c": {"type": ["integer", {"$ref": "#"}]}},)"
+		R"( "patternProperties": {"^d": {"maxItems": 1}}, "dependencies": {"a": "b"}})";
+	std::vector<std::pair<std::string, bool>> const cases = {
+		{R"({"a": "x", "b": 1})", true},
+		{R"({"a": "x", "b": "b", "c": {"a": "xy", "b": 1, "c": 2}})", true},
+		{R"({"a": "x", "b": 2})", false},
+		{R"({"a": "y", "b": 1})", false},
+		{R"({"a": "x"})", false},
+		{R"({"a": "x", "b": 1, "c": {"b": 1}})", false},
+		{R"({"a": "x", "b": 1, "d": [1, 2]})", false},
+	};
+	JsonSchema schema(schema_data);
+	std::string image;
+	schema.Save(image);
+	JsonSchema loaded_schema = JsonSchema::Load(image.data(), image.size());
+	for (auto const &test_case : cases) {
+		ValidationResult result;
+		ValidationResult loaded_result;
+		ValidationResult stream_result;
+		schema.Validate(test_case.first, result);
+		loaded_schema.Validate(test_case.first, loaded_result);
+		// Types of loaded schema are compiled for stream validation.
+		loaded_schema.ValidateStream(test_case.first.c_str(), stream_result);
+		ASSERT_EQ(test_case.second, static_cast<bool>(loaded_result)) << test_case.first;
+		ASSERT_EQ(test_case.second, static_cast<bool>(stream_result)) << test_case.first;
+		ASSERT_EQ(result.ErrorDescription(), loaded_result.ErrorDescription()) << test_case.first;
+	}
+	std::string loaded_image;
+	loaded_schema.Save(loaded_image);
+	ASSERT_EQ(image, loaded_image);
+
+	// Image of document without program is compiled on loading.
+	JsonDocument document;
+	document.Parse(schema_data);
+	std::string document_image;
+	BinarySchema::Write(document, document_image);
+	JsonSchema compiled_schema = JsonSchema::Load(document_image.data(), document_image.size());
+	for (auto const &test_case : cases) {
+		ASSERT_EQ(test_case.second, compiled_schema.IsValid(test_case.first)) << test_case.first;
+	}
+
+	// Corrupted program is rejected or validates documents without access out of its tables, and
+	// its checks of validity and errors agree.
+	size_t rejected_count = 0;
+	for (size_t i = document_image.size(); i < image.size(); ++i) {
+		std::string corrupted = image;
+		corrupted[i] ^= 0x5a;
+		std::unique_ptr<JsonSchema> corrupted_schema;
+		try {
+			corrupted_schema.reset(new JsonSchema(
+				JsonSchema::Load(corrupted.data(), corrupted.size())));
+		}
+		catch (IncorrectSchema const &) {
+			++rejected_count;
+			continue;
+		}
+		for (auto const &test_case : cases) {
+			ValidationResult result;
+			corrupted_schema->Validate(test_case.first, result);
+			ASSERT_EQ(static_cast<bool>(result), corrupted_schema->IsValid(test_case.first))
+				<< i << ": " << test_case.first;
+		}
+	}
+	ASSERT_LT(0u, rejected_count);
+
+	// Program which validates value by the same node recursively is rejected. Such schema isn't
+	// compiled, so reference of extended type to other subschema is replaced by reference to root.
+	std::string recursive_image;
+	JsonSchema(R"({"extends": {"$ref": "#/a"}, "a": {}})").Save(recursive_image);
+	SchemaProgram::Node ref_node = SchemaProgram::Node();
+	ref_node.op = SchemaProgram::kAnyOp;
+	ref_node.kinds = kAnyKind;
+	ref_node.ref_kind = SchemaProgram::kLocalRef;
+	ref_node.ref = 2;
+	size_t const ref_size = offsetof(SchemaProgram::Node, extends);
+	size_t ref_offset = recursive_image.find(
+		std::string(reinterpret_cast<char const *>(&ref_node), ref_size));
+	ASSERT_NE(std::string::npos, ref_offset);
+	ref_node.ref = 0;
+	recursive_image.replace(ref_offset, ref_size,
+	                        std::string(reinterpret_cast<char const *>(&ref_node), ref_size));
+	ASSERT_THROW(JsonSchema::Load(recursive_image.data(), recursive_image.size()), IncorrectSchema);
+}
+
+TEST_F(InternalTests, CheckedSchemasTests) {
+	auto parse = [](char const *data) -> JsonDocument {
+		JsonDocument document;
+		document.Parse(data);
+		return document;
+	};
+	// Equal schemas are found independently of order of members.
+	CheckedSchemas checked_schemas(2, CheckedSchemas::kMaxBytes);
+	checked_schemas.Insert(parse(R"({"a": 1, "b": [true]})"));
+	checked_schemas.Insert(parse(R"({"b": 1})"));
+	checked_schemas.Insert(parse(R"({"b": [true], "a": 1})"));
+	checked_schemas.Insert(parse(R"({"c": 1})"));
+	ASSERT_EQ(2u, checked_schemas.Size());
+	ASSERT_TRUE(checked_schemas.Contains(parse(R"({"b": [true], "a": 1})")));
+	ASSERT_FALSE(checked_schemas.Contains(parse(R"({"c": 1})")));
+	// Integer and floating point numbers are checked differently by meta-schema.
+	ASSERT_FALSE(checked_schemas.Contains(parse(R"({"b": 1.0})")));
+
+	// Size of remembered schemas is limited too.
+	CheckedSchemas small_schemas(CheckedSchemas::kMaxSize, 1);
+	small_schemas.Insert(parse(R"({"a": "long string which exceeds limit of cache"})"));
+	small_schemas.Insert(parse(R"({"b": 1})"));
+	ASSERT_EQ(1u, small_schemas.Size());
+
+	// Different schemas are not remembered after limit of number or size of schemas is reached,
+	// but they are still validated.
+	for (size_t i = 0; i < CheckedSchemas::kMaxSize + 100; ++i) {
+		JsonSchema schema("{\"maxLength\": " + std::to_string(i) + ", \"title\": \"bound\"}");
+		ASSERT_GE(CheckedSchemas::kMaxSize, CheckedSchemas::Global().Size());
+	}
+	size_t const remembered_count = CheckedSchemas::Global().Size();
+	ASSERT_THROW(JsonSchema(R"({"minItems": -2})"), IncorrectDocument);
+	JsonSchema remembered(R"({"maxLength": 0, "title": "bound"})");
+	ASSERT_EQ(remembered_count, CheckedSchemas::Global().Size());
+}
+
+TEST_F(InternalTests, SchemaProgramTests) {
+	// Program lowered from linked tree reports described errors.
+	auto validate = [](std::function<void (JsonValue const &, ValidationContext &)> validate,
+	                   JsonValue const &document, ValidationResult &result) {
+		result.SetMaxErrors(10);
+		ValidationContext context(result);
+		validate(document, context);
+	};
+	auto resolver = std::make_shared<NullResolver>();
+	for (auto const &test : ::Test::GetTests()) {
+		JsonDocument schema_document;
+		schema_document.Parse(test.GetSchema().c_str());
+		JsonTypePtr root = JsonType::Create(schema_document, resolver, "/");
+		LocalSchemas local_schemas(schema_document, root, resolver);
+		root->Link(local_schemas);
+		SchemaProgram program(*root);
+
+		JsonDocument document;
+		document.Parse(test.GetInspectedDocument().c_str());
+		ValidationResult result;
+		validate([&program](JsonValue const &json, ValidationContext &context) {
+			program.Validate(json, context);
+		}, document["data"], result);
+
+		ASSERT_EQ(test.GetExpectResult(), static_cast<bool>(result)) << test.GetName();
+		for (ValidationError const &error : result.GetErrors()) {
+			DocumentErrorPtr description = error.type->CreateError(error.error, error.name);
+			ASSERT_FALSE(description->GetDescription().empty()) << test.GetName();
+		}
+	}
+
+	// Recursive references are lowered to cycles of nodes.
+	JsonDocument schema_document;
+	schema_document.Parse(R"({"properties": {"a": {"$ref": "#"}, "b": {"$ref": "#"}},)"
+	                      R"( "additionalProperties": false})");
+	JsonTypePtr root = JsonType::Create(schema_document, resolver, "/");
+	LocalSchemas local_schemas(schema_document, root, resolver);
+	root->Link(local_schemas);
+	SchemaProgram program(*root);
+	ASSERT_GE(4u, program.GetNodesCount());
+	JsonDocument document;
+	document.Parse(R"({"a": {"b": {"a": {}}}, "b": {"a": {"c": 1}}})");
+	ValidationResult result;
+	validate([&program](JsonValue const &json, ValidationContext &context) {
+		program.Validate(json, context);
+	}, document, result);
+	ASSERT_EQ(1u, result.GetErrors().size());
+	ASSERT_EQ("/b/a", result.GetErrors()[0].path);
+	ASSERT_EQ(DocumentErrors::AdditionalProperty, result.GetErrors()[0].error);
+}
@@ -12,14 +12,24 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <map>
+#include <atomic>
+#include <algorithm>
 #include <memory>
+#include <thread>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <vector>
 #include <functional>
 
 #include <gtest/gtest.h>
 
 #include <JsonSchema.h>
+#include <JsonValidator.h>
 #include <JsonErrors.h>
 #include <JsonDefs.h>
+#include <SchemaRegistry.h>
 
 #include <Test.h>
 #include <Validator.h>
@@ -31,9 +41,12 @@ class JsonSchemaTestSuite : public ::testing::Test
 {
 protected:
 	typedef std::function<bool (::Test const &)> TestFunction;
+	typedef std::function<bool (JsonSchema const &, ::Test const &)> SchemaTestFunction;
 
 	static void CheckTestCase(JsonValue const &test_case, std::string const &filename);
 	static void TestValidator(::Test const &test, TestFunction const &test_func);
+	// Checks function on all tests of suite, schema of each test is compiled once.
+	static void TestSuite(SchemaTestFunction const &test_func);
 }; // class JsonSchemaTestSuite : public ::testing::Test
 
 void JsonSchemaTestSuite::TestValidator(::Test const &test, TestFunction const &test_func) {
@@ -44,6 +57,16 @@ void JsonSchemaTestSuite::TestValidator(::Test const &test, TestFunction const &
 	}
 }
 
+void JsonSchemaTestSuite::TestSuite(SchemaTestFunction const &test_func) {
+	for (auto const &test : ::Test::GetTests()) {
+		JsonSchema schema(test.GetSchema());
+
+		TestValidator(test, [&schema, &test_func](::Test const &test) -> bool {
+			return test_func(schema, test);
+		});
+	}
+}
+
 TEST_F(JsonSchemaTestSuite, AllTests) {
 	for (auto const &test : ::Test::GetTests()) {
 		ValidatorPtr validator = std::make_shared<RJValidator>(test.GetSchema());
@@ -57,3 +80,763 @@ TEST_F(JsonSchemaTestSuite, AllTests) {
 		});
 	}
 }
+
+TEST_F(JsonSchemaTestSuite, IsValidTests) {
+	// Nested checks of union types, disallow and extends fail without failing outer values.
+	char const *const schema_data =
+		R"({"type": "array", "items": {"extends": [{"type": [)"
+		R"({"type": "object", "properties": {"a": {"type": "integer"}}}, "string"]},)"
+		R"( {"disallow": [{"type": "string", "maxLength": 1}]},)"
+		R"( {"dependencies": {"b": "c"}}]}})";
+	JsonSchema schema(schema_data);
+	std::vector<std::pair<std::string, bool>> const cases = {
+		{"[]", true},
+		{R"([{"a": 1}, "ab", {"b": 1, "c": 2}])", true},
+		{R"([{"a": "1"}])", false},
+		{R"(["a"])", false},
+		{R"([1])", false},
+		{R"([{"b": 1}])", false},
+		{R"([{"a": 1}, {"a": 1.5}, "x", {"b": 1}])", false},
+	};
+
+	JsonValidator validator(schema);
+	JsonSchemaOptions options;
+	options.parallel_items_threshold = 2;
+	JsonSchema parallel_schema(schema_data, options);
+	// Long documents are valid or fail only at their first or last element.
+	std::string items = "[";
+	for (int i = 0; i < 1000; ++i) {
+		items += (i == 0 ? "" : ", ") + std::string(R"({"a": 1})");
+	}
+	std::vector<std::pair<std::string, bool>> all_cases = cases;
+	all_cases.push_back({items + "]", true});
+	all_cases.push_back({"[1, " + items.substr(1) + "]", false});
+	all_cases.push_back({items + R"(, {"b": 2}])", false});
+
+	for (auto const &test_case : all_cases) {
+		ValidationResult result;
+		result.SetMaxErrors(10);
+		schema.Validate(test_case.first, result);
+		ASSERT_EQ(test_case.second, static_cast<bool>(result)) << test_case.first;
+		ASSERT_EQ(test_case.second, schema.IsValid(test_case.first)) << test_case.first;
+		ASSERT_EQ(test_case.second, validator.IsValid(test_case.first)) << test_case.first;
+		ASSERT_EQ(test_case.second, parallel_schema.IsValid(test_case.first)) << test_case.first;
+	}
+}
+
+TEST_F(JsonSchemaTestSuite, CollectErrorsTests) {
+	JsonSchema schema(R"({"properties": {"a/b": {"type": "integer"},)"
+	                  R"( "list": {"items": {"maximum": 5}}}, "additionalProperties": false})");
+	std::string const document =
+		R"({"a/b": "1", "list": [1, 6, 2, 7], "extra~name": 1, "other": 2})";
+	char const *const paths[] = {"/a~1b", "/list/1", "/list/3", "", ""};
+
+	ValidationResult result;
+	result.SetMaxErrors(10);
+	{
+		// Names are copied, so errors don't refer to destroyed document.
+		std::string const copy = document;
+		schema.Validate(copy, result);
+	}
+	ASSERT_FALSE(result);
+	ASSERT_EQ(5u, result.GetErrors().size());
+	for (size_t i = 0; i < result.GetErrors().size(); ++i) {
+		ASSERT_EQ(paths[i], result.GetErrors()[i].path) << i;
+		// Document parsed by schema is destroyed, so instances are not available.
+		ASSERT_EQ(nullptr, result.GetErrors()[i].instance);
+	}
+	ASSERT_EQ(DocumentErrors::Type, result.GetErrors()[0].error);
+	ASSERT_EQ(DocumentErrors::AdditionalProperty, result.GetErrors()[3].error);
+	ASSERT_STREQ("extra~name", result.GetErrors()[3].name);
+	ASSERT_STREQ("other", result.GetErrors()[4].name);
+	ASSERT_EQ(result.GetError(), result.GetErrors()[0].error);
+
+	// Errors are limited, instances of given document are kept.
+	JsonDocument parsed;
+	parsed.Parse(document.c_str());
+	result.SetMaxErrors(2);
+	schema.Validate(parsed, result);
+	ASSERT_EQ(2u, result.GetErrors().size());
+	ASSERT_EQ(&parsed["a/b"], result.GetErrors()[0].instance);
+	ASSERT_EQ(&parsed["list"][1], result.GetErrors()[1].instance);
+	ASSERT_EQ("/list/1", result.GetErrors()[1].path);
+
+	// Stream validation stops on the first error.
+	result.SetMaxErrors(10);
+	schema.ValidateStream(R"({"list": [1, 2, 9]})", result);
+	ASSERT_EQ(1u, result.GetErrors().size());
+	ASSERT_EQ("/list/2", result.GetErrors()[0].path);
+}
+
+TEST_F(JsonSchemaTestSuite, DependenciesOrderTests) {
+	// Dependency of member is checked after its value and before next members.
+	JsonSchema schema(R"({"properties": {"b": {"type": "integer"}, "c": {"required": true}},)"
+	                  R"( "dependencies": {"a": "c", "b": ["a", "c"]}})");
+	auto check = [&schema](std::string const &document, std::vector<DocumentErrors> errors,
+	                       std::vector<std::string> names) {
+		ValidationResult result;
+		result.SetMaxErrors(10);
+		schema.Validate(document, result);
+		ASSERT_EQ(errors.size(), result.GetErrors().size()) << document;
+		for (size_t i = 0; i < errors.size(); ++i) {
+			ASSERT_EQ(errors[i], result.GetErrors()[i].error) << document << " " << i;
+			ASSERT_EQ(names[i], result.GetErrors()[i].name ? result.GetErrors()[i].name : "");
+		}
+
+		ValidationResult first_result;
+		schema.Validate(document, first_result);
+		ASSERT_EQ(errors.front(), first_result.GetError()) << document;
+	};
+	check(R"({"a": 1, "b": "x"})",
+	      {DocumentErrors::DependenciesRestrictions, DocumentErrors::Type,
+	       DocumentErrors::DependenciesRestrictions, DocumentErrors::RequiredProperty},
+	      {"a", "", "b", "c"});
+	check(R"({"b": "x", "a": 1})",
+	      {DocumentErrors::Type, DocumentErrors::DependenciesRestrictions,
+	       DocumentErrors::DependenciesRestrictions, DocumentErrors::RequiredProperty},
+	      {"", "b", "a", "c"});
+
+	ValidationResult result;
+	schema.Validate(std::string(R"({"x": 1, "a": 1, "b": 1})"), result);
+	ASSERT_EQ("Element /a doesn't satisfy dependency restriction of property a.",
+	          result.ErrorDescription());
+}
+
+TEST_F(JsonSchemaTestSuite, NumberEqualityTests) {
+	// Fractions are distinct, but differ by less than epsilon from neighbours.
+	std::string fractions = "[";
+	for (int i = 1; i <= 20000; ++i) {
+		fractions += (i == 1 ? "" : ", ") + std::to_string(i) + "e-20";
+	}
+	JsonSchema unique_schema(R"({"uniqueItems": true})");
+	ASSERT_TRUE(unique_schema.IsValid(fractions + "]"));
+	ASSERT_FALSE(unique_schema.IsValid(fractions + ", 7e-20]"));
+	ASSERT_FALSE(unique_schema.IsValid(fractions + ", 0.5, 0.5]"));
+	ASSERT_TRUE(unique_schema.IsValid(R"([0.1, 0.30000000000000004, 0.3, 0])"));
+	ASSERT_FALSE(unique_schema.IsValid(R"([1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 1.0])"));
+	ASSERT_FALSE(unique_schema.IsValid(R"([1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, -0.0, 0])"));
+	ASSERT_TRUE(unique_schema.IsValid(R"([1, 2, 3, 4, 5, 6, 7, 8, 9, 10, -1,)"
+	                                  R"( 18446744073709551615])"));
+
+	JsonSchema enum_schema(R"({"enum": [1e-20, 3, 18446744073709551615]})");
+	ASSERT_TRUE(enum_schema.IsValid("1e-20"));
+	ASSERT_FALSE(enum_schema.IsValid("2e-20"));
+	ASSERT_TRUE(enum_schema.IsValid("3.0"));
+	ASSERT_FALSE(enum_schema.IsValid("-1"));
+}
+
+TEST_F(JsonSchemaTestSuite, LargeEnumTests) {
+	// Values of every kind, objects differ only by order of members.
+	std::string values = R"(null, true, "", 0, -0.5, 18446744073709551615, [], {},)"
+		R"( [1, [2]], {"a": 1, "b": [null, {"c": "d"}]})";
+	for (int i = 0; i < 5000; ++i) {
+		values += ", \"s" + std::to_string(i) + "\", " + std::to_string(i * 3 + 1) + ", [" +
+			std::to_string(i) + R"(, "x"], {"k": )" + std::to_string(i) + "}";
+	}
+	JsonSchema schema("{\"enum\": [" + values + "]}");
+	std::vector<std::pair<char const *, bool>> const cases = {
+		{"null", true},
+		{"false", false},
+		{"true", true},
+		{R"("")", true},
+		{"0.0", true},
+		{"-0.5", true},
+		{"-0.25", false},
+		{"18446744073709551615", true},
+		{"18446744073709551614", false},
+		{"[]", true},
+		{"[[]]", false},
+		{"{}", true},
+		{"[1, [2]]", true},
+		{"[[2], 1]", false},
+		{R"({"b": [null, {"c": "d"}], "a": 1})", true},
+		{R"({"b": [null, {"c": "e"}], "a": 1})", false},
+		{R"("s4999")", true},
+		{R"("s5000")", false},
+		{"14998", true},
+		{"14997", false},
+		{R"([2500, "x"])", true},
+		{R"(["x", 2500])", false},
+		{R"({"k": 4999.0})", true},
+		{R"({"k": 5000})", false},
+	};
+	for (auto const &test_case : cases) {
+		ASSERT_EQ(test_case.second, schema.IsValid(test_case.first)) << test_case.first;
+		ValidationResult result;
+		schema.ValidateStream(test_case.first, result);
+		ASSERT_EQ(test_case.second, static_cast<bool>(result)) << test_case.first;
+	}
+
+	// Typed schema keeps only values of its type.
+	JsonSchema string_schema("{\"type\": \"string\", \"enum\": [" + values + "]}");
+	ASSERT_TRUE(string_schema.IsValid(R"("s2500")"));
+	ASSERT_FALSE(string_schema.IsValid("7501"));
+	ASSERT_FALSE(string_schema.IsValid(R"("s-1")"));
+	JsonSchema null_schema(R"({"type": "null", "enum": [1, null]})");
+	ASSERT_TRUE(null_schema.IsValid("null"));
+
+	// Nulls are equal as elements of arrays too.
+	JsonSchema unique_schema(R"({"uniqueItems": true})");
+	ASSERT_FALSE(unique_schema.IsValid("[null, null]"));
+	ASSERT_FALSE(unique_schema.IsValid("[1, 2, 3, 4, 5, 6, 7, 8, 9, null, null]"));
+}
+
+TEST_F(JsonSchemaTestSuite, SharedTypesTests) {
+	// Shared types validate every property they are used for.
+	JsonSchema schema(R"({"properties": {"a": {"properties": {"x": {"maxLength": 2}}},)"
+	                  R"( "b": {"properties": {"x": {"maxLength": 2}}},)"
+	                  R"( "c": {"items": {"properties": {"x": {"maxLength": 2}}}}}})");
+	ASSERT_TRUE(schema.IsValid(R"({"a": {"x": "1"}, "b": {"x": "2"}, "c": [{"x": "3"}]})"));
+	ValidationResult result;
+	result.SetMaxErrors(3);
+	schema.Validate(R"({"a": {"x": "123"}, "b": {"x": "456"}, "c": [{"x": "789"}]})", result);
+	ASSERT_EQ(3u, result.GetErrors().size());
+	ASSERT_EQ("/a/x", result.GetErrors()[0].path);
+	ASSERT_EQ("/b/x", result.GetErrors()[1].path);
+	ASSERT_EQ("/c/0/x", result.GetErrors()[2].path);
+}
+
+TEST_F(JsonSchemaTestSuite, NameTableTests) {
+	// Required properties are checked by masks wider than inline words of set.
+	std::string schema = R"({"properties": {)";
+	std::string document = "{";
+	for (int i = 0; i < 300; ++i) {
+		schema += (i == 0 ? "" : ", ") + std::string(R"("n)") + std::to_string(i) +
+			R"(": {"required": true})";
+		if (i != 299) {
+			document += (i == 0 ? "" : ", ") + std::string(R"("n)") + std::to_string(i) +
+				R"(": 1)";
+		}
+	}
+	JsonSchema wide_schema(schema + "}}");
+	ASSERT_TRUE(wide_schema.IsValid(document + R"(, "n299": 1})"));
+	ValidationResult result;
+	wide_schema.Validate(document + "}", result);
+	ASSERT_FALSE(result);
+	ASSERT_EQ(DocumentErrors::RequiredProperty, result.GetError());
+	ValidationResult stream_result;
+	wide_schema.ValidateStream((document + "}").c_str(), stream_result);
+	ASSERT_EQ(result.ErrorDescription(), stream_result.ErrorDescription());
+}
+
+TEST_F(JsonSchemaTestSuite, BinaryTests) {
+	char const *const schema_data =
+		R"({"type": "object", "properties": {)"
+		R"("a": {"type": "string", "pattern": "^x", "required": true},)"
+		R"( "b": {"enum": [null, true, -1, 18446744073709551615, 0.5, [], {}]}},)"
+		R"( "title": "\u0000"})";
+	std::string image;
+	JsonSchema(schema_data).Save(image);
+	JsonSchema schema = JsonSchema::Load(image.data(), image.size());
+	ASSERT_TRUE(schema.IsValid(R"({"a": "xy", "b": 18446744073709551615})"));
+	ASSERT_TRUE(schema.IsValid(R"({"a": "x", "b": {}})"));
+	ASSERT_FALSE(schema.IsValid(R"({"b": null})"));
+	ASSERT_FALSE(schema.IsValid(R"({"a": "y"})"));
+	ASSERT_FALSE(schema.IsValid(R"({"b": 0.25})"));
+}
+
+TEST_F(JsonSchemaTestSuite, TrustedSchemaTests) {
+	// Trusted schemas are not validated by meta-schema.
+	JsonSchemaOptions options;
+	options.trusted = true;
+	ASSERT_THROW(JsonSchema(R"({"minItems": -1})"), IncorrectDocument);
+	JsonSchema trusted_schema(R"({"minItems": -1, "maxItems": 1})", options);
+	ASSERT_FALSE(trusted_schema.IsValid("[1, 2]"));
+
+	// Integer and floating point numbers are checked differently by meta-schema.
+	ASSERT_THROW(JsonSchema(R"({"minItems": 1.5})"), IncorrectDocument);
+	JsonSchema integer_schema(R"({"minItems": 1})");
+	ASSERT_THROW(JsonSchema(R"({"minItems": 1.0})"), IncorrectDocument);
+}
+
+namespace {
+
+// Array of objects, where objects with given indexes have too long strings.
+std::string MakeItems(size_t count, std::vector<size_t> const &invalid_indexes) {
+	std::string items = "[";
+	for (size_t i = 0; i < count; ++i) {
+		bool is_invalid = std::find(invalid_indexes.begin(), invalid_indexes.end(), i) !=
+			invalid_indexes.end();
+		items += (i == 0 ? "" : ",");
+		items += is_invalid ? R"({"name": "too long"})" : R"({"name": "ok"})";
+	}
+	return items + "]";
+}
+
+char const *const kItemsSchema =
+	R"({"type": "array", "items": {"type": "object",)"
+	R"( "properties": {"name": {"type": "string", "maxLength": 4}}}})";
+
+} // namespace
+
+TEST_F(JsonSchemaTestSuite, ParallelItemsTests) {
+	JsonSchemaOptions options;
+	options.parallel_items_threshold = 2;
+	JsonSchema schema(kItemsSchema, options);
+	JsonSchema sequential_schema(kItemsSchema);
+
+	JsonDocument document;
+	document.Parse(MakeItems(1000, {7, 500, 501, 998}).c_str());
+	for (size_t max_errors : {1, 3, 8}) {
+		ValidationResult result;
+		ValidationResult sequential_result;
+		result.SetMaxErrors(max_errors);
+		sequential_result.SetMaxErrors(max_errors);
+		schema.Validate(document, result);
+		sequential_schema.Validate(document, sequential_result);
+
+		ASSERT_EQ(sequential_result.ErrorDescription(), result.ErrorDescription());
+		ASSERT_EQ(sequential_result.GetErrors().size(), result.GetErrors().size());
+		for (size_t i = 0; i < result.GetErrors().size(); ++i) {
+			ASSERT_EQ(sequential_result.GetErrors()[i].instance, result.GetErrors()[i].instance);
+		}
+	}
+	ASSERT_FALSE(schema.IsValid(document));
+
+	document.Parse(MakeItems(1000, {}).c_str());
+	ASSERT_TRUE(schema.IsValid(document));
+}
+
+TEST_F(JsonSchemaTestSuite, ParallelItemsBatchTests) {
+	// Items of documents are validated by tasks of the same pool as documents of batch, so
+	// threads wait for items while documents of other tasks are in progress.
+	JsonSchemaOptions options;
+	options.parallel_items_threshold = 2;
+	JsonSchema schema(kItemsSchema, options);
+
+	std::vector<std::string> documents;
+	for (size_t i = 0; i < 50; ++i) {
+		documents.push_back(MakeItems(200, i % 2 ? std::vector<size_t>{i} :
+		                                           std::vector<size_t>{}));
+	}
+	for (size_t round = 0; round < 10; ++round) {
+		std::vector<ValidationResult> results;
+		schema.ValidateBatch(documents, results);
+		ASSERT_EQ(documents.size(), results.size());
+		for (size_t i = 0; i < results.size(); ++i) {
+			ASSERT_EQ(i % 2 == 0, static_cast<bool>(results[i])) << "document " << i;
+		}
+	}
+}
+
+TEST_F(JsonSchemaTestSuite, RegistryLookupTests) {
+	SchemaRegistry registry;
+	JsonSchemaPtr schema = registry.Add("a.json#", R"({"id": "http://x/a#", "type": "integer"})");
+	ASSERT_EQ(schema, registry.Resolve("a.json"));
+	ASSERT_EQ(schema, registry.Resolve("a.json#"));
+	ASSERT_EQ(schema, registry.Resolve("http://x/a"));
+	ASSERT_EQ(schema, registry.Resolve("http://x/a#"));
+	ASSERT_FALSE(registry.Resolve("b.json"));
+
+	// Alias can be added before target.
+	registry.AddAlias("b.json", "c.json#");
+	ASSERT_FALSE(registry.Resolve("b.json"));
+	JsonSchemaPtr target = registry.Add("c.json", R"({"type": "string"})");
+	ASSERT_EQ(target, registry.Resolve("b.json#"));
+
+	// Reference is resolved by registry.
+	JsonSchemaPtr ref_schema = registry.Add("ref", R"({"$ref": "http://x/a#"})");
+	ASSERT_TRUE(ref_schema->IsValid("1"));
+	ASSERT_FALSE(ref_schema->IsValid(R"("1")"));
+
+	SchemaRegistry::Reader reader(registry);
+	ASSERT_EQ(schema.get(), reader.Find("http://x/a"));
+	ASSERT_EQ(target.get(), reader.Find("b.json"));
+	ASSERT_EQ(nullptr, reader.Find("d.json"));
+}
+
+TEST_F(JsonSchemaTestSuite, RegistryCacheTests) {
+	SchemaRegistry registry;
+	char const *const content = R"({"type": "object", "properties": {"a": {"type": "integer"}}})";
+	char const *const same_content =
+		R"({"properties": {"a": {"type": "integer"}}, "type": "object"})";
+	JsonSchemaPtr schema = registry.Add("a", content);
+	ASSERT_EQ(schema, registry.Add("b", same_content));
+	ASSERT_NE(schema, registry.Add("c", R"({"type": "object"})"));
+
+	// Trusted schema is not checked by meta-schema, so it isn't used for untrusted one.
+	JsonSchemaPtr trusted = registry.Add("trusted", R"({"type": "array"})", true);
+	ASSERT_NE(trusted, registry.Add("untrusted", R"({"type": "array"})"));
+	// Checked schema can be used for trusted one.
+	ASSERT_EQ(schema, registry.Add("d", content, true));
+
+	// Schemas with external references depend on registered schemas, so they aren't shared.
+	ASSERT_NE(registry.Add("e", R"({"$ref": "a"})"), registry.Add("f", R"({"$ref": "a"})"));
+}
+
+TEST_F(JsonSchemaTestSuite, RegistryReaderTests) {
+	SchemaRegistry registry;
+	registry.Add("a", R"({"type": "integer"})");
+	{
+		SchemaRegistry::Reader reader(registry);
+		ASSERT_THROW(registry.Add("a", R"({"type": "string"})"), std::logic_error);
+		ASSERT_THROW(registry.AddAlias("b", "a"), std::logic_error);
+		ASSERT_TRUE(reader.Find("a")->IsValid("1"));
+	}
+	registry.Add("a", R"({"type": "string"})");
+
+	// Schema replaced by other thread isn't destroyed while reader exists: writer started after
+	// reader is still blocked while reader is alive.
+	std::promise<void> started;
+	std::promise<void> replaced;
+	std::future<void> replaced_future = replaced.get_future();
+	std::thread writer;
+	{
+		SchemaRegistry::Reader reader(registry);
+		JsonSchema const *schema = reader.Find("a");
+		writer = std::thread([&registry, &started, &replaced] {
+			started.set_value();
+			registry.Add("a", R"({"type": "boolean"})");
+			replaced.set_value();
+		});
+		started.get_future().wait();
+		EXPECT_EQ(std::future_status::timeout,
+		          replaced_future.wait_for(std::chrono::milliseconds(20)));
+		EXPECT_TRUE(schema->IsValid(R"("1")"));
+		EXPECT_FALSE(schema->IsValid("true"));
+		EXPECT_EQ(std::future_status::timeout, replaced_future.wait_for(std::chrono::seconds(0)));
+	}
+	replaced_future.wait();
+	writer.join();
+	ASSERT_TRUE(SchemaRegistry::Reader(registry).Find("a")->IsValid("true"));
+}
+
+TEST_F(JsonSchemaTestSuite, RegistryReloadTests) {
+	SchemaRegistry registry;
+	for (auto const &test : ::Test::GetTests()) {
+		// Every version differs by content, so it is compiled again.
+		auto make_version = [&test](int version) -> std::string {
+			std::string const &schema = test.GetSchema();
+			size_t const begin = schema.find('{') + 1;
+			size_t const next = schema.find_first_not_of(" \t\r\n", begin);
+			return "{\"x-version\": " + std::to_string(version) +
+			       (schema[next] == '}' ? "" : ", ") + schema.substr(begin);
+		};
+		registry.Add("test", make_version(0));
+
+		std::atomic<bool> stop(false);
+		std::atomic<size_t> errors(0);
+		std::vector<std::thread> readers;
+		for (int i = 0; i < 2; ++i) {
+			readers.emplace_back([&] {
+				while (!stop) {
+					SchemaRegistry::Reader reader(registry);
+					if (reader.Find("test")->IsValid(test.GetInspectedData()) !=
+					    test.GetExpectResult()) {
+						++errors;
+					}
+				}
+			});
+		}
+		for (int version = 1; version <= 4; ++version) {
+			registry.Add("test", make_version(version));
+		}
+		stop = true;
+		for (auto &reader : readers) {
+			reader.join();
+		}
+		ASSERT_EQ(0u, errors.load()) << test.GetName();
+	}
+}
+
+TEST_F(JsonSchemaTestSuite, RefErrorsLifetimeTests) {
+	// Errors raised by referenced schemas are described after the schemas are replaced in
+	// registry. Context has room for four pinned schemas, other schemas are kept by result.
+	SchemaRegistry registry;
+	std::string schema_data = "{\"properties\": {";
+	std::string document = "{";
+	for (int i = 0; i < 6; ++i) {
+		std::string const name = std::to_string(i);
+		registry.Add(name, "{\"type\": \"integer\", \"minimum\": " + std::to_string(10 + i) +
+		             "}");
+		schema_data += (i ? ", \"" : "\"") + name + "\": {\"$ref\": \"" + name + "\"}";
+		document += (i ? ", \"" : "\"") + name + "\": 1";
+	}
+	JsonSchemaPtr schema = registry.Add("schema", schema_data + "}}");
+	document += "}";
+
+	ValidationResult result;
+	result.SetMaxErrors(10);
+	schema->Validate(document, result);
+	std::string const description = result.ErrorDescription();
+	std::vector<std::string> descriptions;
+	for (auto const &error : result.GetErrors()) {
+		descriptions.push_back(error.type->CreateError(error.error, error.name)->GetDescription());
+	}
+	ASSERT_EQ(6u, descriptions.size());
+
+	for (int i = 0; i < 6; ++i) {
+		registry.Add(std::to_string(i), R"({"type": "string"})");
+	}
+	ASSERT_EQ(description, result.ErrorDescription());
+	for (size_t i = 0; i < descriptions.size(); ++i) {
+		ValidationError const &error = result.GetErrors()[i];
+		ASSERT_EQ(descriptions[i],
+		          error.type->CreateError(error.error, error.name)->GetDescription());
+	}
+}
+
+namespace {
+
+// Resolver of external references by map, which can be changed between validations.
+class MapResolver : public JsonResolver {
+public:
+	MapResolver() : schemas(), resolves_count(0) {}
+
+	virtual JsonSchemaPtr Resolve(std::string const &ref) const {
+		++resolves_count;
+		auto it = schemas.find(ref);
+		return it != schemas.end() ? it->second : JsonSchemaPtr();
+	}
+
+	std::map<std::string, JsonSchemaPtr> schemas;
+	mutable size_t resolves_count;
+}; // class MapResolver
+
+} // namespace
+
+TEST_F(JsonSchemaTestSuite, RefBindingTests) {
+	// Equal subschemas share type, so the same reference is linked twice.
+	JsonSchema local_schema(R"({"properties": {"a": {"$ref": "#/definitions/integer"},)"
+	                        R"( "b": {"$ref": "#/definitions/integer"}},)"
+	                        R"( "definitions": {"integer": {"type": "integer"}}})");
+	ASSERT_TRUE(local_schema.IsValid(R"({"a": 1, "b": 2})"));
+	ASSERT_FALSE(local_schema.IsValid(R"({"a": "1"})"));
+	ASSERT_FALSE(local_schema.IsValid(R"({"b": "2"})"));
+
+	auto resolver = std::make_shared<MapResolver>();
+	resolver->schemas["target"] = std::make_shared<JsonSchema>(R"({"type": "integer"})");
+	JsonSchemaOptions options;
+	options.resolver = resolver;
+	JsonSchema schema(R"({"properties": {"a": {"$ref": "target"}}})", options);
+	ASSERT_TRUE(schema.IsValid(R"({"a": 1})"));
+	ASSERT_FALSE(schema.IsValid(R"({"a": "1"})"));
+
+	ASSERT_EQ(1u, resolver->resolves_count);
+
+	// Bound target is destroyed and replaced by other schema, reference is bound again.
+	resolver->schemas["target"] = std::make_shared<JsonSchema>(R"({"type": "string"})");
+	ASSERT_FALSE(schema.IsValid(R"({"a": 1})"));
+	ASSERT_TRUE(schema.IsValid(R"({"a": "1"})"));
+	ASSERT_EQ(2u, resolver->resolves_count);
+	ValidationResult result;
+	schema.Validate(std::string(R"({"a": 1})"), result);
+	ASSERT_FALSE(result);
+
+	// Reference of program read from image is bound on loading.
+	std::string image;
+	schema.Save(image);
+	JsonSchema loaded_schema = JsonSchema::Load(image.data(), image.size(), resolver);
+	ASSERT_EQ(3u, resolver->resolves_count);
+	ASSERT_FALSE(loaded_schema.IsValid(R"({"a": 1})"));
+	ASSERT_TRUE(loaded_schema.IsValid(R"({"a": "1"})"));
+	ASSERT_EQ(3u, resolver->resolves_count);
+
+	// Target is destroyed and not replaced, so reference is not checked. Result which has error of
+	// target keeps it alive until it is cleared.
+	result.Clear();
+	resolver->schemas.clear();
+	ASSERT_TRUE(schema.IsValid(R"({"a": 1})"));
+	ASSERT_TRUE(schema.IsValid(R"({"a": "1"})"));
+}
+
+TEST_F(JsonSchemaTestSuite, RefRebindingTests) {
+	// Reference of long-lived schema is bound again after every reload of target, while other
+	// threads validate documents by the schema.
+	SchemaRegistry registry;
+	registry.Add("target", R"({"type": "integer"})");
+	JsonSchemaPtr schema = registry.Add("schema", R"({"properties": {"a": {"$ref": "target"}}})");
+	std::atomic<bool> stop(false);
+	std::vector<std::thread> validators;
+	for (int i = 0; i < 4; ++i) {
+		validators.emplace_back([&] {
+			while (!stop) {
+				schema->IsValid(R"({"a": 1})");
+			}
+		});
+	}
+	for (int version = 0; version < 200; ++version) {
+		registry.Add("target", "{\"type\": \"integer\", \"x-version\": " +
+		             std::to_string(version) + "}");
+	}
+	stop = true;
+	for (auto &validator : validators) {
+		validator.join();
+	}
+	ASSERT_TRUE(schema->IsValid(R"({"a": 1})"));
+	ASSERT_FALSE(schema->IsValid(R"({"a": "1"})"));
+}
+
+TEST_F(JsonSchemaTestSuite, RecursiveRefTests) {
+	// References which lead to validation of the same value by the same schema are rejected.
+	ASSERT_THROW(JsonSchema(R"({"$ref": "#"})"), IncorrectSchema);
+	ASSERT_THROW(JsonSchema(R"({"extends": {"$ref": "#"}})"), IncorrectSchema);
+	ASSERT_THROW(JsonSchema(R"({"$ref": "#/definitions/a", "definitions": {)"
+	                        R"("a": {"$ref": "#/definitions/b"}, "b": {"$ref": "#/definitions/a"}}})"),
+	             IncorrectSchema);
+
+	// Recursion through nested values is finite for every document.
+	JsonSchema schema(R"({"properties": {"a": {"$ref": "#"}}, "additionalProperties": false})");
+	ASSERT_TRUE(schema.IsValid(R"({"a": {"a": {}}})"));
+	ASSERT_FALSE(schema.IsValid(R"({"a": {"b": 1}})"));
+}
+
+TEST_F(JsonSchemaTestSuite, StreamTests) {
+	TestSuite([](JsonSchema const &schema, ::Test const &test) -> bool {
+		ValidationResult result;
+		schema.ValidateStream(test.GetInspectedData().c_str(), result);
+		return result;
+	});
+}
+
+TEST_F(JsonSchemaTestSuite, StreamRefTests) {
+	// Containers checked by referenced and extended schemas are streamed, so error is reported
+	// before the rest of document is parsed.
+	char const *const schemas[] = {
+		R"({"$ref": "#/definitions/x",)"
+		R"( "definitions": {"x": {"properties": {"a": {"type": "string"}}}}})",
+		R"({"extends": {"properties": {"a": {"type": "string"}}}})",
+		R"({"type": "object", "extends": [{}, {"$ref": "#/x"}],)"
+		R"( "x": {"properties": {"a": {"type": "string"}}}})",
+	};
+	char const *const document = R"({"b": [1, {}], "a": 1})";
+	for (char const *schema_data : schemas) {
+		JsonSchema schema(schema_data);
+		ValidationResult result;
+		ValidationResult stream_result;
+		schema.Validate(std::string(document), result);
+		schema.ValidateStream(document, stream_result);
+		ASSERT_FALSE(stream_result) << schema_data;
+		ASSERT_EQ(result.ErrorDescription(), stream_result.ErrorDescription()) << schema_data;
+		ValidationResult truncated_result;
+		ASSERT_NO_THROW(schema.ValidateStream(R"({"b": [1, {}], "a": 1, "c": )",
+		                                      truncated_result)) << schema_data;
+		ASSERT_FALSE(truncated_result) << schema_data;
+	}
+
+	// Enum compares whole value, so referenced enum is collected.
+	JsonSchema enum_schema(R"({"$ref": "#/x", "x": {"enum": [{"a": 1}]}})");
+	ValidationResult enum_result;
+	ASSERT_THROW(enum_schema.ValidateStream(R"({"a": 2, "c": )", enum_result), IncorrectJson);
+}
+
+TEST_F(JsonSchemaTestSuite, StreamWideObjectTests) {
+	JsonSchema schema("{\"type\": \"object\", \"properties\": {"
+	                  "\"a\": {\"required\": true}, \"b\": {}, \"c\": {}},"
+	                  "\"dependencies\": {\"b\": \"c\"}}");
+	auto make_document = [](std::string const &members) -> std::string {
+		std::string document = "{";
+		for (int i = 0; i < 10000; ++i) {
+			document += "\"m" + std::to_string(i) + "\": " + std::to_string(i) + ", ";
+		}
+		return document + members + "}";
+	};
+
+	std::vector<std::pair<std::string, bool>> const cases = {
+		{"\"a\": 1, \"b\": 2, \"c\": 3", true},
+		{"\"b\": 2, \"c\": 3", false},
+		{"\"a\": 1, \"b\": 2", false},
+		{"\"x\": {\"a\": 1}", false},
+	};
+	for (auto const &test_case : cases) {
+		std::string const document = make_document(test_case.first);
+		ValidationResult result;
+		ValidationResult stream_result;
+		schema.Validate(document, result);
+		schema.ValidateStream(document.c_str(), stream_result);
+		ASSERT_EQ(test_case.second, static_cast<bool>(stream_result)) << test_case.first;
+		ASSERT_EQ(result.ErrorDescription(), stream_result.ErrorDescription()) << test_case.first;
+	}
+}
+
+TEST_F(JsonSchemaTestSuite, BatchTests) {
+	TestSuite([](JsonSchema const &schema, ::Test const &test) -> bool {
+		std::vector<std::string> documents(64, test.GetInspectedData());
+		std::vector<ValidationResult> results;
+		schema.ValidateBatch(documents, results);
+		for (auto const &result : results) {
+			if (static_cast<bool>(result) != static_cast<bool>(results.front())) {
+				ADD_FAILURE() << "Different results of batch for " << test.GetName();
+			}
+		}
+		return results.front();
+	});
+}
+
+TEST_F(JsonSchemaTestSuite, ValidatorTests) {
+	// Buffers of validator are enlarged by large documents and reused by following ones.
+	JsonValidator validator{JsonSchema(R"({"items": {"properties": {"name": {"maxLength": 4}}}})")};
+	auto make_items = [](size_t count, std::string const &name) -> std::string {
+		std::string items = "[";
+		for (size_t i = 0; i < count; ++i) {
+			items += (i == 0 ? "" : ", ") + std::string(R"({"id": 1, "name": ")") + name + "\"}";
+		}
+		return items + "]";
+	};
+	std::string const long_name(1024 * 1024, 'x');
+
+	std::vector<std::pair<std::string, bool>> const cases = {
+		{make_items(1, "a"), true},
+		{make_items(100000, "abcd"), true},
+		{make_items(2, "abcde"), false},
+		{make_items(1, long_name), false},
+		{make_items(3, "ab"), true},
+		{make_items(100000, "abcde"), false},
+		{"[]", true},
+	};
+	for (size_t round = 0; round < 2; ++round) {
+		for (size_t i = 0; i < cases.size(); ++i) {
+			ValidationResult result;
+			validator.Validate(cases[i].first, result);
+			ASSERT_EQ(cases[i].second, static_cast<bool>(result)) << "document " << i;
+			ASSERT_EQ(cases[i].second, validator.IsValid(cases[i].first)) << "document " << i;
+
+			std::vector<char> buffer(cases[i].first.begin(), cases[i].first.end());
+			validator.ValidateInsitu(buffer.data(), buffer.size(), result);
+			ASSERT_EQ(cases[i].second, static_cast<bool>(result)) << "document " << i;
+		}
+	}
+
+	// Incorrect document doesn't break validator.
+	ValidationResult result;
+	ASSERT_THROW(validator.Validate(R"([{"name": "a"}, {)"), IncorrectJson);
+	validator.Validate(make_items(10, "abc"), result);
+	ASSERT_TRUE(result);
+}
+
+TEST_F(JsonSchemaTestSuite, InsituTests) {
+	TestSuite([](JsonSchema const &schema, ::Test const &test) -> bool {
+		std::string const data = test.GetInspectedData();
+		std::vector<char> document(data.begin(), data.end());
+		ValidationResult result;
+		schema.ValidateInsitu(document.data(), document.size(), result);
+
+		JsonValidator validator(schema);
+		std::vector<char> validator_document(data.begin(), data.end());
+		ValidationResult validator_result;
+		validator.ValidateInsitu(validator_document.data(), validator_document.size(),
+		                         validator_result);
+		if (static_cast<bool>(validator_result) != static_cast<bool>(result)) {
+			ADD_FAILURE() << "Different results of validator for " << test.GetName();
+		}
+		return result;
+	});
+}
+
+TEST_F(JsonSchemaTestSuite, LengthTests) {
+	// Documents are followed by garbage which must not be parsed.
+	TestSuite([](JsonSchema const &schema, ::Test const &test) -> bool {
+		std::string const data = test.GetInspectedData();
+		std::string const buffer = data + "}garbage";
+		ValidationResult result;
+		schema.Validate(buffer.data(), data.size(), result);
+
+		JsonValidator validator(schema);
+		ValidationResult validator_result;
+		validator.Validate(buffer.data(), data.size(), validator_result);
+		if (static_cast<bool>(validator_result) != static_cast<bool>(result)) {
+			ADD_FAILURE() << "Different results of validator for " << test.GetName();
+		}
+		return result;
+	});
+}
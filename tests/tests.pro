@@ -21,12 +21,14 @@ QT -= core gui
 
 INCLUDEPATH += ../thirdparty/rapidjson/include/ \
                ../include/ \
+               ../lib/ \
                ../tests_common/ \
 
 
 LIBS += -L$${DESTDIR} -ltests_common -lre2 -lboost_filesystem -lboost_system -lgtest -lgtest_main
 
-SOURCES = JsonSchemaTestSuite.cc \
+SOURCES = InternalTests.cc \
+          JsonSchemaTestSuite.cc \
 
 
 PRE_TARGETDEPS += $${DESTDIR}/libtests_common.a
@@ -47,8 +47,7 @@ std::vector<fs::path> GetTestFiles()
 	std::vector<fs::path> test_files;
 	std::copy_if(it, endIt, std::back_inserter(test_files), [](fs::directory_entry const &entry) -> bool {
 		return fs::is_regular_file(entry) &&
-		       boost::algorithm::ends_with(entry.path().string(), ".json") &&
-		       entry.path().filename().string() != "ref.json";
+		       boost::algorithm::ends_with(entry.path().string(), ".json");
 	});
 	return test_files;
 }
@@ -63,14 +62,13 @@ void LoadTestCases(fs::path const &path_to_file, JsonSchemaValidator::JsonDocume
 
 std::string GetStringTestData(JsonSchemaValidator::JsonValue const &test_data) {
 	std::stringstream ss;
-	ss << std::boolalpha << std::fixed << "{\"data\": ";
+	ss << std::boolalpha << std::fixed;
 	if (test_data.IsObject() || test_data.IsArray()) ss << ToString(test_data);
 	else if (test_data.IsString()) ss << "\"" << test_data.GetString() << "\"";
 	else if (test_data.IsDouble()) ss << test_data.GetDouble();
 	else if (test_data.IsNumber()) ss << test_data.GetInt64();
 	else if (test_data.IsBool()) ss << test_data.GetBool();
 	else if (test_data.IsNull()) ss << "null";
-	ss << "}";
 	return ss.str();
 }
 
@@ -78,10 +76,10 @@ std::string GetStringTestData(JsonSchemaValidator::JsonValue const &test_data) {
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 Test::Test(std::string const &name, std::string const &schema,
-           std::string const &inspected_document, bool expect_result)
+           std::string const &inspected_data, bool expect_result)
 	: name_(name)
 	, schema_(schema)
-	, inspected_document_(inspected_document)
+	, inspected_data_(inspected_data)
 	, expect_result_(expect_result) {
 }
 
@@ -94,7 +92,11 @@ std::string Test::GetSchema() const {
 }
 
 std::string Test::GetInspectedDocument() const {
-	return inspected_document_;
+	return "{\"data\": " + inspected_data_ + "}";
+}
+
+std::string Test::GetInspectedData() const {
+	return inspected_data_;
 }
 
 bool Test::GetExpectResult() const {
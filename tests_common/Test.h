@@ -28,11 +28,12 @@ typedef std::vector<Test> Tests;
 class Test {
 public:
 	Test(std::string const &name, std::string const &schema,
-	     std::string const &inspected_document, bool expect_result);
+	     std::string const &inspected_data, bool expect_result);
 
 	std::string GetName() const;
 	std::string GetSchema() const;
 	std::string GetInspectedDocument() const;
+	std::string GetInspectedData() const;
 	bool GetExpectResult() const;
 
 	static Tests GetTests();
@@ -40,7 +41,7 @@ public:
 private:
 	std::string name_;
 	std::string schema_;
-	std::string inspected_document_;
+	std::string inspected_data_;
 	bool expect_result_;
 }; // class Test
 
@@ -38,6 +38,10 @@ jsvor::ValidationResult RJValidator::Validate() {
 	return Validate(document_, value_);
 }
 
+bool RJValidator::IsValid() {
+	return value_ ? schema_.IsValid(*value_) : schema_.IsValid(document_);
+}
+
 void RJValidator::Load(std::string const &json,
                        jsvor::JsonDocument &document, jsvor::JsonValue const * &value) {
 	document.Parse<0>(json.c_str());
@@ -51,6 +51,8 @@ public:
 
 	virtual void Load(std::string const &json);
 	virtual jsvor::ValidationResult Validate();
+	// Check loaded document without description of error (see JsonSchema::IsValid).
+	bool IsValid();
 
 private:
 	void Load(std::string const &json,